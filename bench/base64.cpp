@@ -0,0 +1,99 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+// Compares the speed of the base64 encoder with the boost iterator based one used earlier for album pictures.
+
+#include <base64.h>
+
+#include <boost/archive/iterators/base64_from_binary.hpp>
+#include <boost/archive/iterators/transform_width.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace boost::archive::iterators;
+
+typedef base64_from_binary<transform_width<const unsigned char*, 6, 8>> BoostBase64;
+
+// =====================================================================================================================
+template<typename F>
+static double measure(const std::string& name, size_t size, int rounds, F encode)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; ++i)
+	encode();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double mbps = static_cast<double>(size) * rounds / elapsed.count() / (1024 * 1024);
+
+    std::cout << "  " << name << ": " << mbps << " MB/s" << std::endl;
+
+    return mbps;
+}
+
+// =====================================================================================================================
+int main(int argc, char** argv)
+{
+    std::mt19937 rng(42);
+
+    // typical sizes of album covers
+    for (size_t size : {1000, 30 * 1000, 300 * 1000, 3000 * 1000})
+    {
+	std::vector<unsigned char> data(size);
+
+	for (auto& b : data)
+	    b = rng();
+
+	std::string reference;
+	std::copy(BoostBase64(&data[0]), BoostBase64(&data[0] + size), std::back_inserter(reference));
+
+	std::string result;
+	Base64::encode(&data[0], size, result);
+
+	std::string scalar(Base64::encodedSize(size), '\0');
+	Base64::encodeScalar(&data[0], size, &scalar[0]);
+
+	if (result != reference || scalar != reference)
+	{
+	    std::cerr << "output mismatch at size " << size << std::endl;
+	    return 1;
+	}
+
+	int rounds = static_cast<int>(200 * 1000 * 1000 / size);
+
+	std::cout << size << " bytes:" << std::endl;
+
+	double boost = measure("boost iterators", size, rounds,
+	    [&]()
+	    {
+		std::string out;
+		std::copy(BoostBase64(&data[0]), BoostBase64(&data[0] + size), std::back_inserter(out));
+	    });
+
+	measure("scalar", size, rounds,
+	    [&]()
+	    {
+		std::string out(Base64::encodedSize(size), '\0');
+		Base64::encodeScalar(&data[0], size, &out[0]);
+	    });
+
+	double best = measure("dispatched", size, rounds,
+	    [&]()
+	    {
+		std::string out;
+		Base64::encode(&data[0], size, out);
+	    });
+
+	std::cout << "  speedup: " << best / boost << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,460 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+// Measures the throughput of the JSON-RPC server on a synthetic library, without running zeppelin itself.
+//
+// usage: server-bench [number of files] [seconds per method]
+
+#include <server.h>
+#include <msgpackwriter.h>
+#include <jsonreader.h>
+
+#include <zeppelin/library/storage.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace zeppelin;
+
+// allocations are counted globally, the benchmark runs the calls on a single thread
+static std::atomic<unsigned long long> s_allocations(0);
+
+// =====================================================================================================================
+void* operator new(size_t size)
+{
+    ++s_allocations;
+
+    void* p = malloc(size ? size : 1);
+
+    if (!p)
+	throw std::bad_alloc();
+
+    return p;
+}
+
+// =====================================================================================================================
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+/**
+ * Album picture with generated contents, only its accessors are used by the server.
+ */
+class BenchPicture : public library::Picture
+{
+    public:
+	BenchPicture(const std::string& mimeType, const std::vector<unsigned char>& data)
+	    : m_mimeType(mimeType),
+	      m_data(data)
+	{}
+
+	const std::string& getMimeType() const override
+	{ return m_mimeType; }
+	const std::vector<unsigned char>& getData() const override
+	{ return m_data; }
+
+    private:
+	std::string m_mimeType;
+	std::vector<unsigned char> m_data;
+};
+
+/**
+ * Storage serving a generated library from memory. The objects are created up front to measure the server only.
+ */
+class BenchStorage : public library::Storage
+{
+    public:
+	BenchStorage(int files)
+	{
+	    int albums = std::max(1, files / 10);
+	    int artists = std::max(1, albums / 5);
+
+	    for (int i = 1; i <= artists; ++i)
+		m_artists.push_back(std::make_shared<library::Artist>(i, "Artist " + std::to_string(i), 5));
+
+	    for (int i = 1; i <= albums; ++i)
+	    {
+		m_albums.push_back(std::make_shared<library::Album>(i, "Album " + std::to_string(i), (i - 1) / 5 + 1, 10));
+		// every album has a directory of its own under the first one
+		m_directories.push_back(
+		    std::make_shared<library::Directory>(i, "Directory " + std::to_string(i), i == 1 ? -1 : 1));
+	    }
+
+	    for (int i = 1; i <= files; ++i)
+	    {
+		int album = (i - 1) / 10 + 1;
+
+		auto f = std::make_shared<library::File>(i);
+		f->m_path = "/music/Artist " + std::to_string((album - 1) / 5 + 1) + "/Album " + std::to_string(album);
+		f->m_name = std::to_string(i % 10 + 1) + " - Track " + std::to_string(i) + ".flac";
+		f->m_directoryId = album;
+		f->m_artistId = (album - 1) / 5 + 1;
+		f->m_albumId = album;
+		f->m_metadata.reset(new library::Metadata("flac"));
+
+		m_files.push_back(f);
+	    }
+
+	    m_picture = std::make_shared<BenchPicture>("image/jpeg", std::vector<unsigned char>(30 * 1000, 0x55));
+	}
+
+	library::Statistics getStatistics() override
+	{
+	    library::Statistics stat;
+
+	    stat.m_numOfArtists = m_artists.size();
+	    stat.m_numOfAlbums = m_albums.size();
+	    stat.m_numOfFiles = m_files.size();
+	    stat.m_sumOfSongLengths = 0;
+	    stat.m_sumOfFileSizes = 0;
+
+	    return stat;
+	}
+
+	std::vector<std::shared_ptr<library::Artist>> getArtists(const std::vector<int>& ids) override
+	{ return select(m_artists, ids); }
+	std::vector<std::shared_ptr<library::Album>> getAlbums(const std::vector<int>& ids) override
+	{ return select(m_albums, ids); }
+	std::vector<std::shared_ptr<library::File>> getFiles(const std::vector<int>& ids) override
+	{ return select(m_files, ids); }
+	std::vector<std::shared_ptr<library::Directory>> getDirectories(const std::vector<int>& ids) override
+	{ return select(m_directories, ids); }
+
+	std::vector<int> getAlbumIdsByArtist(int artistId) override
+	{
+	    std::vector<int> ids;
+
+	    for (const auto& a : m_albums)
+	    {
+		if (a->m_artistId == artistId)
+		    ids.push_back(a->m_id);
+	    }
+
+	    return ids;
+	}
+
+	std::map<int, std::map<library::Picture::Type, std::shared_ptr<library::Picture>>> getPicturesOfAlbums(
+	    const std::vector<int>& ids) override
+	{
+	    std::map<int, std::map<library::Picture::Type, std::shared_ptr<library::Picture>>> pictures;
+
+	    for (int id : ids)
+		pictures[id][library::Picture::FrontCover] = m_picture;
+
+	    return pictures;
+	}
+
+	std::vector<int> getFileIdsOfAlbum(int albumId) override
+	{
+	    std::vector<int> ids;
+
+	    for (int i = (albumId - 1) * 10 + 1; i <= albumId * 10 && i <= static_cast<int>(m_files.size()); ++i)
+		ids.push_back(i);
+
+	    return ids;
+	}
+
+	std::vector<int> getFileIdsOfDirectory(int directoryId) override
+	{ return getFileIdsOfAlbum(directoryId); }
+
+	std::vector<int> getSubdirectoryIdsOfDirectory(int directoryId) override
+	{
+	    std::vector<int> ids;
+
+	    if (directoryId == 1)
+	    {
+		for (size_t i = 2; i <= m_directories.size(); ++i)
+		    ids.push_back(i);
+	    }
+
+	    return ids;
+	}
+
+	void updateFileMetadata(const library::File& file) override
+	{}
+
+	int createPlaylist(const std::string& name) override
+	{ return 1; }
+	void deletePlaylist(int id) override
+	{}
+	int addPlaylistItem(int id, const std::string& type, int itemId) override
+	{ return 1; }
+	void deletePlaylistItem(int id) override
+	{}
+	std::vector<std::shared_ptr<library::Playlist>> getPlaylists(const std::vector<int>& ids) override
+	{ return {}; }
+
+    private:
+	// objects are stored by id - 1, an empty id list selects all of them like the real storage does
+	template<typename T>
+	static std::vector<std::shared_ptr<T>> select(const std::vector<std::shared_ptr<T>>& objects,
+						      const std::vector<int>& ids)
+	{
+	    if (ids.empty())
+		return objects;
+
+	    std::vector<std::shared_ptr<T>> result;
+	    result.reserve(ids.size());
+
+	    for (int id : ids)
+	    {
+		if (id >= 1 && id <= static_cast<int>(objects.size()))
+		    result.push_back(objects[id - 1]);
+	    }
+
+	    return result;
+	}
+
+    private:
+	std::vector<std::shared_ptr<library::Artist>> m_artists;
+	std::vector<std::shared_ptr<library::Album>> m_albums;
+	std::vector<std::shared_ptr<library::Directory>> m_directories;
+	std::vector<std::shared_ptr<library::File>> m_files;
+	std::shared_ptr<library::Picture> m_picture;
+};
+
+class BenchLibrary : public library::MusicLibrary
+{
+    public:
+	BenchLibrary(int files)
+	    : m_storage(files)
+	{}
+
+	library::Storage& getStorage() override
+	{ return m_storage; }
+
+	void scan() override
+	{}
+
+	Status getStatus() override
+	{
+	    Status status;
+
+	    status.m_scannerRunning = false;
+	    status.m_metaParserRunning = false;
+
+	    return status;
+	}
+
+    private:
+	BenchStorage m_storage;
+};
+
+class BenchController : public player::Controller
+{
+    public:
+	BenchController(const std::shared_ptr<library::File>& file)
+	    : m_queue(std::make_shared<player::Queue>())
+	{
+	    m_status.m_file = file;
+	    m_status.m_state = PLAYING;
+	    m_status.m_position = 42;
+	    m_status.m_volume = 80;
+	    m_status.m_index = {0, 3};
+	}
+
+	std::shared_ptr<player::Queue> getQueue() const override
+	{ return m_queue; }
+	Status getStatus() override
+	{ return m_status; }
+
+	void queue(const std::shared_ptr<player::QueueItem>& item) override
+	{}
+	void remove(const std::vector<int>& index) override
+	{}
+	void removeAll() override
+	{}
+
+	void play() override
+	{}
+	void pause() override
+	{}
+	void stop() override
+	{}
+	void seek(int seconds) override
+	{}
+	void prev() override
+	{}
+	void next() override
+	{}
+	void goTo(const std::vector<int>& index) override
+	{}
+
+	int getVolume() const override
+	{ return m_status.m_volume; }
+	void setVolume(int level) override
+	{}
+
+    private:
+	std::shared_ptr<player::Queue> m_queue;
+	Status m_status;
+};
+
+struct Scenario
+{
+    std::string m_name;
+    std::string m_body;
+    ResponseWriter::Format m_format;
+};
+
+// =====================================================================================================================
+static std::string call(const std::string& method, const std::string& params)
+{
+    return "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"" + method + "\",\"params\":" + params + "}";
+}
+
+// =====================================================================================================================
+static std::string idList(int first, int count)
+{
+    std::string ids = "[";
+
+    for (int i = 0; i < count; ++i)
+	ids += (i ? "," : "") + std::to_string(first + i);
+
+    return ids + "]";
+}
+
+// =====================================================================================================================
+static std::string toMsgPack(const std::string& json)
+{
+    Arena arena;
+    JsonValue value;
+    JsonReader(arena).parse(json, value);
+
+    std::string result;
+    MsgPackWriter writer(result);
+    writer.value(value);
+
+    return result;
+}
+
+// =====================================================================================================================
+static void run(Server& server, const Scenario& scenario, double seconds)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<double> latencies;
+    unsigned long long allocations = 0;
+    size_t responseSize = 0;
+
+    // the first calls fill the caches of the server, they are not measured
+    for (int i = 0; i < 3; ++i)
+    {
+	Arena arena;
+	server.processBody(scenario.m_body, arena, scenario.m_format);
+    }
+
+    auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    while (Clock::now() < end)
+    {
+	unsigned long long before = s_allocations;
+	auto start = Clock::now();
+
+	{
+	    Arena arena;
+	    responseSize = server.processBody(scenario.m_body, arena, scenario.m_format).size();
+	}
+
+	latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+	allocations += s_allocations - before;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    double total = 0;
+
+    for (double l : latencies)
+	total += l;
+
+    auto percentile = [&latencies](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+
+    std::cout << std::left << std::setw(32) << scenario.m_name << std::right << std::fixed << std::setprecision(1)
+	      << std::setw(12) << latencies.size() / (total / 1e6)
+	      << std::setw(10) << percentile(0.5)
+	      << std::setw(10) << percentile(0.9)
+	      << std::setw(10) << percentile(0.99)
+	      << std::setw(10) << latencies.back()
+	      << std::setw(10) << static_cast<double>(allocations) / latencies.size()
+	      << std::setw(10) << responseSize
+	      << std::endl;
+}
+
+// =====================================================================================================================
+int main(int argc, char** argv)
+{
+    int files = argc > 1 ? atoi(argv[1]) : 10000;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+
+    if (files < 10 || seconds <= 0)
+    {
+	std::cerr << "usage: " << argv[0] << " [number of files (at least 10)] [seconds per method]" << std::endl;
+	return 1;
+    }
+
+    auto library = std::make_shared<BenchLibrary>(files);
+    auto ctrl = std::make_shared<BenchController>(library->getStorage().getFiles({1})[0]);
+
+    // the server is not started, batches are executed on the calling thread
+    Server server(library, ctrl);
+
+    int albums = std::max(1, files / 10);
+
+    std::vector<Scenario> scenarios = {
+	{"library_get_statistics", call("library_get_statistics", "{}"), ResponseWriter::JSON},
+	{"library_get_artists (all)", call("library_get_artists", "{\"id\":[]}"), ResponseWriter::JSON},
+	{"library_get_albums (all)", call("library_get_albums", "{\"id\":[]}"), ResponseWriter::JSON},
+	{"library_get_files (1000)", call("library_get_files", "{\"id\":" + idList(1, std::min(files, 1000)) + "}"),
+	 ResponseWriter::JSON},
+	{"library_get_files (fields)",
+	 call("library_get_files",
+	      "{\"id\":" + idList(1, std::min(files, 1000)) + ",\"fields\":[\"id\",\"title\",\"length\"]}"),
+	 ResponseWriter::JSON},
+	{"library_get_files (columns)",
+	 call("library_get_files", "{\"id\":" + idList(1, std::min(files, 1000)) + ",\"format\":\"columns\"}"),
+	 ResponseWriter::JSON},
+	{"library_list_files (100)", call("library_list_files", "{\"limit\":100}"), ResponseWriter::JSON},
+	{"library_get_file_ids_of_album", call("library_get_file_ids_of_album", "{\"album_id\":1}"),
+	 ResponseWriter::JSON},
+	{"library_get_pictures_of_albums",
+	 call("library_get_pictures_of_albums", "{\"id\":" + idList(1, std::min(albums, 16)) + "}"),
+	 ResponseWriter::JSON},
+	{"player_status", call("player_status", "{}"), ResponseWriter::JSON},
+	{"player_queue_get", call("player_queue_get", "{}"), ResponseWriter::JSON},
+	{"batch (4 calls)",
+	 "[" + call("player_status", "{}") + "," + call("player_get_volume", "{}") + "," +
+	 call("library_get_status", "{}") + "," + call("library_get_file_ids_of_album", "{\"album_id\":1}") + "]",
+	 ResponseWriter::JSON},
+	{"player_status (msgpack)", toMsgPack(call("player_status", "{}")), ResponseWriter::MSGPACK},
+	{"library_get_files (msgpack)",
+	 toMsgPack(call("library_get_files", "{\"id\":" + idList(1, std::min(files, 1000)) + "}")),
+	 ResponseWriter::MSGPACK}
+    };
+
+    std::cout << "library of " << files << " files, " << seconds << " s per method" << std::endl;
+    std::cout << std::left << std::setw(32) << "method" << std::right
+	      << std::setw(12) << "calls/s"
+	      << std::setw(10) << "p50 us"
+	      << std::setw(10) << "p90 us"
+	      << std::setw(10) << "p99 us"
+	      << std::setw(10) << "max us"
+	      << std::setw(10) << "allocs"
+	      << std::setw(10) << "bytes"
+	      << std::endl;
+
+    for (const auto& s : scenarios)
+	run(server, s, seconds);
+
+    return 0;
+}
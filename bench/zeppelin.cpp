@@ -0,0 +1,222 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+// Minimal definitions of the zeppelin core symbols used by the plugin sources. The plugin gets them from the zeppelin
+// executable when it is loaded, the standalone benchmark has to provide them itself. Only what the server needs for
+// building responses and queue items is implemented, the objects are never played.
+
+#include <zeppelin/logger.h>
+#include <zeppelin/library/metadata.h>
+#include <zeppelin/player/queue.h>
+
+#include <iostream>
+
+using namespace zeppelin;
+
+// =====================================================================================================================
+void Logger::log(const std::string& message)
+{
+    std::cerr << message << std::endl;
+}
+
+// =====================================================================================================================
+library::Metadata::Metadata(const std::string& codec)
+    : m_year(0),
+      m_trackIndex(0),
+      m_codec(codec),
+      m_length(0),
+      m_sampleRate(0),
+      m_sampleSize(0)
+{
+}
+
+// =====================================================================================================================
+int library::Metadata::getLength() const
+{
+    return m_length;
+}
+
+// =====================================================================================================================
+const std::string& library::Metadata::getTitle() const
+{
+    return m_title;
+}
+
+// =====================================================================================================================
+int library::Metadata::getYear() const
+{
+    return m_year;
+}
+
+// =====================================================================================================================
+int library::Metadata::getTrackIndex() const
+{
+    return m_trackIndex;
+}
+
+// =====================================================================================================================
+const std::string& library::Metadata::getCodec() const
+{
+    return m_codec;
+}
+
+// =====================================================================================================================
+int library::Metadata::getSampleRate() const
+{
+    return m_sampleRate;
+}
+
+// =====================================================================================================================
+int library::Metadata::getSampleSize() const
+{
+    return m_sampleSize;
+}
+
+// =====================================================================================================================
+const std::string& library::Metadata::getArtist() const
+{
+    return m_artist;
+}
+
+// =====================================================================================================================
+const std::string& library::Metadata::getAlbum() const
+{
+    return m_album;
+}
+
+// =====================================================================================================================
+void library::Metadata::setArtist(const std::string& artist)
+{
+    m_artist = artist;
+}
+
+// =====================================================================================================================
+void library::Metadata::setAlbum(const std::string& album)
+{
+    m_album = album;
+}
+
+// =====================================================================================================================
+void library::Metadata::setTitle(const std::string& title)
+{
+    m_title = title;
+}
+
+// =====================================================================================================================
+void library::Metadata::setYear(int year)
+{
+    m_year = year;
+}
+
+// =====================================================================================================================
+void library::Metadata::setTrackIndex(int trackIndex)
+{
+    m_trackIndex = trackIndex;
+}
+
+// =====================================================================================================================
+player::QueueItem::~QueueItem()
+{
+}
+
+// =====================================================================================================================
+std::shared_ptr<library::File> player::QueueItem::file() const
+{
+    return nullptr;
+}
+
+// =====================================================================================================================
+player::File::File(const std::shared_ptr<library::File>& file)
+    : m_f(file)
+{
+}
+
+// =====================================================================================================================
+player::QueueItem::Type player::File::type() const
+{
+    return FILE;
+}
+
+// =====================================================================================================================
+std::shared_ptr<library::File> player::File::file() const
+{
+    return m_f;
+}
+
+// =====================================================================================================================
+void player::Container::add(const std::shared_ptr<QueueItem>& item)
+{
+    m_items.push_back(item);
+}
+
+// =====================================================================================================================
+const std::vector<std::shared_ptr<player::QueueItem>>& player::Container::items() const
+{
+    return m_items;
+}
+
+// =====================================================================================================================
+player::Directory::Directory(const std::shared_ptr<library::Directory>& directory)
+    : m_d(directory)
+{
+}
+
+// =====================================================================================================================
+player::QueueItem::Type player::Directory::type() const
+{
+    return DIRECTORY;
+}
+
+// =====================================================================================================================
+const library::Directory& player::Directory::directory() const
+{
+    return *m_d;
+}
+
+// =====================================================================================================================
+player::Album::Album(const std::shared_ptr<library::Album>& album,
+		     const std::vector<std::shared_ptr<library::File>>& files)
+    : m_a(album)
+{
+    for (const auto& f : files)
+	add(std::make_shared<File>(f));
+}
+
+// =====================================================================================================================
+player::QueueItem::Type player::Album::type() const
+{
+    return ALBUM;
+}
+
+// =====================================================================================================================
+const library::Album& player::Album::album() const
+{
+    return *m_a;
+}
+
+// =====================================================================================================================
+player::Playlist::Playlist(int id)
+    : m_id(id)
+{
+}
+
+// =====================================================================================================================
+player::QueueItem::Type player::Playlist::type() const
+{
+    return PLAYLIST;
+}
+
+// =====================================================================================================================
+int player::Playlist::getId() const
+{
+    return m_id;
+}
+
+// =====================================================================================================================
+player::QueueItem::Type player::Queue::type() const
+{
+    return PLAYLIST;
+}
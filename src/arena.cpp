@@ -0,0 +1,68 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+static const size_t MIN_BLOCK_SIZE = 16 * 1024;
+static const size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+// =====================================================================================================================
+Arena::Arena()
+    : m_current(m_inline),
+      m_end(m_inline + INLINE_SIZE),
+      m_blockSize(MIN_BLOCK_SIZE)
+{
+}
+
+// =====================================================================================================================
+Arena::~Arena()
+{
+    reset();
+}
+
+// =====================================================================================================================
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    uintptr_t p = (reinterpret_cast<uintptr_t>(m_current) + alignment - 1) & ~(alignment - 1);
+
+    if (p + size > reinterpret_cast<uintptr_t>(m_end))
+    {
+	// blocks are growing to keep the number of heap allocations logarithmic in the size of the request, huge
+	// allocations get a block of their own
+	size_t blockSize = std::max(m_blockSize, size + alignment);
+
+	char* block = new char[blockSize];
+	m_blocks.push_back(block);
+
+	m_current = block;
+	m_end = block + blockSize;
+
+	if (m_blockSize < MAX_BLOCK_SIZE)
+	    m_blockSize *= 2;
+
+	p = (reinterpret_cast<uintptr_t>(m_current) + alignment - 1) & ~(alignment - 1);
+    }
+
+    m_current = reinterpret_cast<char*>(p + size);
+
+    return reinterpret_cast<void*>(p);
+}
+
+// =====================================================================================================================
+void Arena::reset()
+{
+    for (char* block : m_blocks)
+	delete[] block;
+
+    m_blocks.clear();
+
+    m_current = m_inline;
+    m_end = m_inline + INLINE_SIZE;
+    m_blockSize = MIN_BLOCK_SIZE;
+}
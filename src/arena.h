@@ -0,0 +1,103 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_ARENA_H_INCLUDED
+#define JSONRPCREMOTE_ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+ * Monotonic allocator for objects living as long as a single request. Memory is never given back one by one, the
+ * whole arena is released at once. The first few kilobytes come from a buffer inside the object, small requests are
+ * handled without touching the heap if the arena itself is allocated on the stack.
+ */
+class Arena
+{
+    public:
+	Arena();
+	~Arena();
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template<typename T>
+	T* allocate(size_t count)
+	{ return static_cast<T*>(allocate(count * sizeof(T), alignof(T))); }
+
+	// releases every allocation made so far
+	void reset();
+
+    private:
+	static const size_t INLINE_SIZE = 4096;
+
+	alignas(std::max_align_t) char m_inline[INLINE_SIZE];
+
+	char* m_current;
+	char* m_end;
+
+	// size of the next block allocated from the heap
+	size_t m_blockSize;
+	std::vector<char*> m_blocks;
+};
+
+/**
+ * Standard allocator adaptor for using the arena with containers. Deallocation is a no-op, the memory is released with
+ * the arena. Without an arena the allocator falls back to the heap, this allows the same container type to be used
+ * by objects living inside and outside of requests.
+ */
+template<typename T>
+class ArenaAllocator
+{
+    public:
+	typedef T value_type;
+
+	ArenaAllocator(Arena& arena)
+	    : m_arena(&arena)
+	{}
+
+	ArenaAllocator(Arena* arena)
+	    : m_arena(arena)
+	{}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other)
+	    : m_arena(other.m_arena)
+	{}
+
+	T* allocate(size_t count)
+	{ return m_arena ? m_arena->allocate<T>(count) : static_cast<T*>(::operator new(count * sizeof(T))); }
+	void deallocate(T* p, size_t)
+	{ if (!m_arena) ::operator delete(p); }
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const
+	{ return m_arena == other.m_arena; }
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const
+	{ return m_arena != other.m_arena; }
+
+    private:
+	template<typename U>
+	friend class ArenaAllocator;
+
+	Arena* m_arena;
+};
+
+/**
+ * Deleter for objects constructed in an arena, it runs the destructor only and leaves the memory to the arena.
+ */
+template<typename T>
+struct ArenaDeleter
+{
+    void operator()(T* p) const
+    { p->~T(); }
+};
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "base64.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_X86
+#include <immintrin.h>
+#endif
+
+static const char* s_alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+typedef void (*EncodeFunction)(const unsigned char*, size_t, char*);
+
+#ifdef BASE64_X86
+// =====================================================================================================================
+// Converts the 12 input bytes at the beginning of each 16 byte lane into 16 base64 characters.
+// See "Faster Base64 Encoding and Decoding Using AVX2 Instructions" by Wojciech Muła and Daniel Lemire for the details.
+__attribute__((target("ssse3")))
+static inline __m128i encodeLane(__m128i in)
+{
+    // reorder the bytes to make every 32 bit word contain the 24 bits of one 3 byte group
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    // split the groups into 6 bit indices, one in each byte
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t1, t3);
+
+    // translate the indices to characters by adding the offset of the alphabet range they belong to
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+					  '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+}
+
+// =====================================================================================================================
+__attribute__((target("ssse3")))
+static void encodeSsse3(const unsigned char* data, size_t size, char* out)
+{
+    // 16 bytes are loaded for every 12 bytes of input, stop while a full load is still inside the buffer
+    while (size >= 16)
+    {
+	__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), encodeLane(in));
+
+	data += 12;
+	size -= 12;
+	out += 16;
+    }
+
+    Base64::encodeScalar(data, size, out);
+}
+
+// =====================================================================================================================
+__attribute__((target("avx2")))
+static inline __m256i encodeLanes(__m256i in)
+{
+    in = _mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+						 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    __m256i indices = _mm256_or_si256(t1, t3);
+
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    range = _mm256_or_si256(range, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+					     '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+					     'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+					     '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    return _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+}
+
+// =====================================================================================================================
+__attribute__((target("avx2")))
+static void encodeAvx2(const unsigned char* data, size_t size, char* out)
+{
+    // each 128 bit lane gets 12 bytes of input, the second load ends 28 bytes after the current position
+    while (size >= 28)
+    {
+	__m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	__m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 12));
+	__m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), encodeLanes(in));
+
+	data += 24;
+	size -= 24;
+	out += 32;
+    }
+
+    encodeSsse3(data, size, out);
+}
+#endif
+
+// =====================================================================================================================
+static EncodeFunction selectEncoder()
+{
+#ifdef BASE64_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+	return encodeAvx2;
+    if (__builtin_cpu_supports("ssse3"))
+	return encodeSsse3;
+#endif
+
+    return Base64::encodeScalar;
+}
+
+// =====================================================================================================================
+void Base64::encode(const unsigned char* data, size_t size, char* out)
+{
+    static const EncodeFunction encoder = selectEncoder();
+    encoder(data, size, out);
+}
+
+// =====================================================================================================================
+void Base64::encode(const unsigned char* data, size_t size, std::string& out)
+{
+    size_t offset = out.size();
+
+    out.resize(offset + encodedSize(size));
+    encode(data, size, &out[offset]);
+}
+
+// =====================================================================================================================
+void Base64::encodeScalar(const unsigned char* data, size_t size, char* out)
+{
+    while (size >= 3)
+    {
+	unsigned v = (data[0] << 16) | (data[1] << 8) | data[2];
+
+	out[0] = s_alphabet[(v >> 18) & 0x3f];
+	out[1] = s_alphabet[(v >> 12) & 0x3f];
+	out[2] = s_alphabet[(v >> 6) & 0x3f];
+	out[3] = s_alphabet[v & 0x3f];
+
+	data += 3;
+	size -= 3;
+	out += 4;
+    }
+
+    // the remaining bits are padded with zeros, no padding characters are written
+    if (size == 1)
+    {
+	out[0] = s_alphabet[data[0] >> 2];
+	out[1] = s_alphabet[(data[0] & 0x03) << 4];
+    }
+    else if (size == 2)
+    {
+	out[0] = s_alphabet[data[0] >> 2];
+	out[1] = s_alphabet[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+	out[2] = s_alphabet[(data[1] & 0x0f) << 2];
+    }
+}
@@ -0,0 +1,39 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_BASE64_H_INCLUDED
+#define JSONRPCREMOTE_BASE64_H_INCLUDED
+
+#include <string>
+
+/**
+ * Base64 encoder producing output without padding characters. The fastest implementation supported by the CPU
+ * (AVX2, SSSE3 or the portable one) is selected at runtime.
+ */
+class Base64
+{
+    public:
+	/**
+	 * Returns the number of characters the encoded form of size bytes takes.
+	 */
+	static size_t encodedSize(size_t size)
+	{ return (size * 4 + 2) / 3; }
+
+	/**
+	 * Encodes size bytes of data into out. The output buffer must be able to hold encodedSize(size) characters.
+	 */
+	static void encode(const unsigned char* data, size_t size, char* out);
+
+	/**
+	 * Appends the encoded form of the data to the given string.
+	 */
+	static void encode(const unsigned char* data, size_t size, std::string& out);
+
+	// the portable implementation, public to make comparison with the vectorized versions possible
+	static void encodeScalar(const unsigned char* data, size_t size, char* out);
+};
+
+#endif
@@ -0,0 +1,236 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "changelog.h"
+
+#include <algorithm>
+#include <map>
+
+// =====================================================================================================================
+ChangeLog::ChangeLog(size_t capacity, unsigned long long first)
+    : m_capacity(capacity),
+      m_generation(first),
+      m_scanGeneration(0),
+      m_horizon(first)
+{
+}
+
+// =====================================================================================================================
+uint64_t ChangeLog::digest(const std::string& data)
+{
+    // 64 bit FNV-1a, collisions only matter if a modified object happens to keep its digest
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (unsigned char c : data)
+    {
+	hash ^= c;
+	hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// =====================================================================================================================
+unsigned long long ChangeLog::getScanGeneration()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_scanGeneration;
+}
+
+// =====================================================================================================================
+void ChangeLog::update(unsigned long long scanGeneration, Snapshot (&snapshots)[KIND_COUNT])
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (scanGeneration <= m_scanGeneration)
+	return;
+
+    // the first snapshot is the base of the log, nothing is known about the changes before it
+    if (m_scanGeneration != 0)
+    {
+	unsigned long long generation = ++m_generation;
+
+	for (int kind = 0; kind < KIND_COUNT; ++kind)
+	    compare(generation, static_cast<Kind>(kind), snapshots[kind]);
+    }
+
+    m_scanGeneration = scanGeneration;
+
+    for (int kind = 0; kind < KIND_COUNT; ++kind)
+	m_snapshots[kind].swap(snapshots[kind]);
+
+    shrink();
+}
+
+// =====================================================================================================================
+void ChangeLog::modify(Kind kind, int id, uint64_t digest)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_scanGeneration == 0)
+	return;
+
+    // the snapshot is kept up to date to avoid reporting the same change again after the next scan
+    Snapshot& snapshot = m_snapshots[kind];
+    auto it = std::lower_bound(snapshot.begin(), snapshot.end(), std::make_pair(id, uint64_t(0)));
+
+    if (it != snapshot.end() && it->first == id)
+    {
+	if (it->second == digest)
+	    return;
+
+	it->second = digest;
+	add(++m_generation, kind, id, MODIFIED);
+    }
+    else
+    {
+	snapshot.insert(it, std::make_pair(id, digest));
+	add(++m_generation, kind, id, ADDED);
+    }
+
+    shrink();
+}
+
+// =====================================================================================================================
+void ChangeLog::modify(Kind kind, Snapshot& snapshot)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_scanGeneration == 0)
+	return;
+
+    // a new generation is started only if there is anything to record in it
+    if (compare(m_generation + 1, kind, snapshot))
+	++m_generation;
+
+    m_snapshots[kind].swap(snapshot);
+
+    shrink();
+}
+
+// =====================================================================================================================
+bool ChangeLog::getChanges(unsigned long long since, unsigned long long& generation, Changes (&changes)[KIND_COUNT])
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    generation = m_generation;
+
+    if (m_scanGeneration == 0 || since < m_horizon || since > m_generation)
+	return false;
+
+    std::map<int, Type> types[KIND_COUNT];
+
+    // entries are ordered by generation, the older changes of an id are combined with the newer ones
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), since,
+	[](unsigned long long g, const Entry& e)
+	{
+	    return g < e.m_generation;
+	});
+
+    for (; it != m_entries.end(); ++it)
+    {
+	std::map<int, Type>& t = types[it->m_kind];
+	auto prev = t.find(it->m_id);
+
+	if (prev == t.end())
+	{
+	    t[it->m_id] = static_cast<Type>(it->m_type);
+	    continue;
+	}
+
+	switch (it->m_type)
+	{
+	    case ADDED :
+		// deleted and added again
+		prev->second = MODIFIED;
+		break;
+
+	    case MODIFIED :
+		// an added object stays added
+		break;
+
+	    case DELETED :
+		if (prev->second == ADDED)
+		    t.erase(prev);
+		else
+		    prev->second = DELETED;
+		break;
+	}
+    }
+
+    for (int kind = 0; kind < KIND_COUNT; ++kind)
+    {
+	for (const auto& t : types[kind])
+	{
+	    switch (t.second)
+	    {
+		case ADDED : changes[kind].m_added.push_back(t.first); break;
+		case MODIFIED : changes[kind].m_modified.push_back(t.first); break;
+		case DELETED : changes[kind].m_deleted.push_back(t.first); break;
+	    }
+	}
+    }
+
+    return true;
+}
+
+// =====================================================================================================================
+bool ChangeLog::compare(unsigned long long generation, Kind kind, const Snapshot& after)
+{
+    const Snapshot& before = m_snapshots[kind];
+    size_t size = m_entries.size();
+
+    // both snapshots are sorted by id, the differences are found by merging them
+    auto b = before.begin();
+    auto a = after.begin();
+
+    while (b != before.end() || a != after.end())
+    {
+	if (a == after.end() || (b != before.end() && b->first < a->first))
+	{
+	    add(generation, kind, b->first, DELETED);
+	    ++b;
+	}
+	else if (b == before.end() || a->first < b->first)
+	{
+	    add(generation, kind, a->first, ADDED);
+	    ++a;
+	}
+	else
+	{
+	    if (a->second != b->second)
+		add(generation, kind, a->first, MODIFIED);
+
+	    ++a;
+	    ++b;
+	}
+    }
+
+    return m_entries.size() != size;
+}
+
+// =====================================================================================================================
+void ChangeLog::add(unsigned long long generation, Kind kind, int id, Type type)
+{
+    Entry e;
+    e.m_generation = generation;
+    e.m_id = id;
+    e.m_kind = kind;
+    e.m_type = type;
+
+    m_entries.push_back(e);
+}
+
+// =====================================================================================================================
+void ChangeLog::shrink()
+{
+    // the oldest generations are dropped as a whole, clients behind them have to download the library again
+    while (m_entries.size() > m_capacity)
+    {
+	m_horizon = std::max(m_horizon, m_entries.front().m_generation);
+	m_entries.pop_front();
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_CHANGELOG_H_INCLUDED
+#define JSONRPCREMOTE_CHANGELOG_H_INCLUDED
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Records the ids of the library objects added, modified or deleted in each generation of the log. The storage does
+ * not report what a scan changed, so the changes of scans are found by comparing snapshots holding a digest of every
+ * object. Changes made through the server are recorded one by one, or by comparing new snapshots of the affected kinds.
+ * Changes older than the first snapshot or dropped because of the capacity of the log are not known.
+ */
+class ChangeLog
+{
+    public:
+	enum Kind
+	{
+	    ARTIST,
+	    ALBUM,
+	    FILE,
+	    DIRECTORY,
+	    KIND_COUNT
+	};
+
+	// (id, digest) pairs of the objects of a kind sorted by id
+	typedef std::vector<std::pair<int, uint64_t>> Snapshot;
+
+	struct Changes
+	{
+	    std::vector<int> m_added;
+	    std::vector<int> m_modified;
+	    std::vector<int> m_deleted;
+	};
+
+	// the generation of the first snapshot is the given one, it should differ between runs to make sure generations
+	// handed out by an earlier run are not accepted
+	ChangeLog(size_t capacity, unsigned long long first);
+
+	static uint64_t digest(const std::string& data);
+
+	// returns the scan generation of the last snapshot or 0 if there is no snapshot yet
+	unsigned long long getScanGeneration();
+
+	// records the differences between the previous snapshots and the given ones taken in the given scan generation as
+	// the changes of a new generation, snapshots of older scan generations are ignored
+	void update(unsigned long long scanGeneration, Snapshot (&snapshots)[KIND_COUNT]);
+
+	// records the new digest of a single object changed outside of scans, nothing is recorded before the first
+	// snapshot or if the digest did not change
+	void modify(Kind kind, int id, uint64_t digest);
+	// records the differences between the current snapshot of a kind and the given one taken outside of scans, used
+	// when a change affects objects of the kind not known in advance
+	void modify(Kind kind, Snapshot& snapshot);
+
+	// collects the changes made after the given generation, the same id is reported once with the combined effect of
+	// its changes; returns false if the log does not reach back to the given generation
+	bool getChanges(unsigned long long since, unsigned long long& generation, Changes (&changes)[KIND_COUNT]);
+
+    private:
+	enum Type
+	{
+	    ADDED,
+	    MODIFIED,
+	    DELETED
+	};
+
+	struct Entry
+	{
+	    unsigned long long m_generation;
+	    int m_id;
+	    uint8_t m_kind;
+	    uint8_t m_type;
+	};
+
+	// records the differences between the snapshot of a kind and the given one in the given generation, returns
+	// true if there was any
+	bool compare(unsigned long long generation, Kind kind, const Snapshot& after);
+	void add(unsigned long long generation, Kind kind, int id, Type type);
+	// drops the oldest entries exceeding the capacity of the log
+	void shrink();
+
+    private:
+	size_t m_capacity;
+
+	// generation of the last recorded change
+	unsigned long long m_generation;
+	// scan generation of the current snapshots
+	unsigned long long m_scanGeneration;
+	// changes made after this generation are all in the log
+	unsigned long long m_horizon;
+
+	Snapshot m_snapshots[KIND_COUNT];
+	std::deque<Entry> m_entries;
+
+	std::mutex m_mutex;
+};
+
+#endif
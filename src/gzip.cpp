@@ -0,0 +1,37 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "gzip.h"
+
+#include <zlib.h>
+
+// =====================================================================================================================
+bool Gzip::compress(const std::string& in, std::string& out, int level)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    // 16 is added to the window bits to get a gzip header instead of a zlib one
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	return false;
+
+    // the output is allocated in one step with the worst case size of the compressed data
+    out.resize(deflateBound(&stream, in.size()));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    stream.avail_in = in.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = out.size();
+
+    int ret = deflate(&stream, Z_FINISH);
+
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    return ret == Z_STREAM_END;
+}
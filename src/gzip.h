@@ -0,0 +1,22 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_GZIP_H_INCLUDED
+#define JSONRPCREMOTE_GZIP_H_INCLUDED
+
+#include <string>
+
+class Gzip
+{
+    public:
+	/**
+	 * Compresses the input into a gzip stream with the given zlib compression level (1-9). Returns false if the
+	 * compression failed, the contents of out are undefined in this case.
+	 */
+	static bool compress(const std::string& in, std::string& out, int level);
+};
+
+#endif
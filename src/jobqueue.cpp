@@ -0,0 +1,190 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "jobqueue.h"
+
+#include <exception>
+
+// =====================================================================================================================
+JobQueue::JobQueue(size_t history)
+    : m_history(history),
+      m_nextId(1)
+{
+}
+
+// =====================================================================================================================
+void JobQueue::start()
+{
+    m_worker.start(1);
+}
+
+// =====================================================================================================================
+void JobQueue::stop()
+{
+    // the pending jobs are cancelled to avoid delaying the shutdown with building large queue items
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for (auto& it : m_jobs)
+	    it.second->m_cancelled = true;
+    }
+
+    m_worker.stop();
+}
+
+// =====================================================================================================================
+int JobQueue::submit(const Task& task)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    int id;
+
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	id = m_nextId++;
+	m_jobs[id] = job;
+
+	// forget the oldest finished jobs, the ones still pending or running are kept regardless of the limit
+	for (auto it = m_jobs.begin(); m_jobs.size() > m_history && it != m_jobs.end(); )
+	{
+	    if (it->second->m_state == PENDING || it->second->m_state == RUNNING)
+		++it;
+	    else
+		it = m_jobs.erase(it);
+	}
+    }
+
+    m_worker.submit(std::bind(&JobQueue::execute, this, job, task));
+
+    return id;
+}
+
+// =====================================================================================================================
+void JobQueue::run(const std::function<void()>& task)
+{
+    bool idle = true;
+
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for (const auto& it : m_jobs)
+	{
+	    if (it.second->m_state == PENDING || it.second->m_state == RUNNING)
+	    {
+		idle = false;
+		break;
+	    }
+	}
+    }
+
+    if (idle)
+    {
+	task();
+	return;
+    }
+
+    // the single worker gets to the task after the pending jobs only
+    m_worker.submit(task).get();
+}
+
+// =====================================================================================================================
+bool JobQueue::getState(int id, State& state, std::string& error) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(id);
+
+    if (it == m_jobs.end())
+	return false;
+
+    state = it->second->m_state;
+    error = it->second->m_error;
+
+    return true;
+}
+
+// =====================================================================================================================
+bool JobQueue::cancel(int id)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(id);
+
+    if (it == m_jobs.end())
+	return false;
+
+    Job& job = *it->second;
+
+    switch (job.m_state)
+    {
+	case PENDING :
+	    // the worker skips it when it gets to it
+	    job.m_cancelled = true;
+	    job.m_state = CANCELLED;
+	    return true;
+
+	case RUNNING :
+	    // the task decides whether it is too late to stop, the final state is set when it returns
+	    job.m_cancelled = true;
+	    return true;
+
+	default :
+	    return false;
+    }
+}
+
+// =====================================================================================================================
+const char* JobQueue::stateName(State state)
+{
+    switch (state)
+    {
+	case PENDING : return "pending";
+	case RUNNING : return "running";
+	case DONE : return "done";
+	case FAILED : return "failed";
+	case CANCELLED : return "cancelled";
+    }
+
+    return "";
+}
+
+// =====================================================================================================================
+void JobQueue::execute(const std::shared_ptr<Job>& job, const Task& task)
+{
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (job->m_cancelled)
+	{
+	    job->m_state = CANCELLED;
+	    return;
+	}
+
+	job->m_state = RUNNING;
+    }
+
+    try
+    {
+	finish(job, task(job->m_cancelled) ? DONE : CANCELLED, "");
+    }
+    catch (const std::exception& e)
+    {
+	finish(job, FAILED, e.what());
+    }
+    catch (...)
+    {
+	finish(job, FAILED, "unknown error");
+    }
+}
+
+// =====================================================================================================================
+void JobQueue::finish(const std::shared_ptr<Job>& job, State state, const std::string& error)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    job->m_state = state;
+    job->m_error = error;
+}
@@ -0,0 +1,85 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_JOBQUEUE_H_INCLUDED
+#define JSONRPCREMOTE_JOBQUEUE_H_INCLUDED
+
+#include "threadpool.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * Executes long running tasks in the background one by one in the order they were submitted. The tasks are identified
+ * by an id the clients can use for following their state or for cancelling them. The state of finished jobs is kept
+ * for a limited number of jobs only.
+ */
+class JobQueue
+{
+    public:
+	enum State
+	{
+	    PENDING,
+	    RUNNING,
+	    DONE,
+	    FAILED,
+	    CANCELLED
+	};
+
+	// the task should check the flag at its safe points and return false if it gave up because of the cancellation
+	typedef std::function<bool(const std::atomic<bool>& cancelled)> Task;
+
+	JobQueue(size_t history);
+
+	void start();
+	void stop();
+
+	// returns the id of the new job
+	int submit(const Task& task);
+
+	// executes the task after the jobs submitted so far, on the calling thread if there are none; used for keeping
+	// synchronous calls in order with the jobs, the exceptions of the task are passed to the caller
+	void run(const std::function<void()>& task);
+
+	// returns false if the job is not known (anymore), the error is set for failed jobs only
+	bool getState(int id, State& state, std::string& error) const;
+
+	// returns false if the job is not known or it is already finished
+	bool cancel(int id);
+
+	static const char* stateName(State state);
+
+    private:
+	struct Job
+	{
+	    Job() : m_state(PENDING), m_cancelled(false) {}
+
+	    State m_state;
+	    std::string m_error;
+	    std::atomic<bool> m_cancelled;
+	};
+
+	void execute(const std::shared_ptr<Job>& job, const Task& task);
+	void finish(const std::shared_ptr<Job>& job, State state, const std::string& error);
+
+    private:
+	size_t m_history;
+
+	int m_nextId;
+	// the ids are increasing, the oldest jobs are at the beginning of the map
+	std::map<int, std::shared_ptr<Job>> m_jobs;
+
+	mutable std::mutex m_mutex;
+
+	// a single worker keeps the order of the jobs, e.g. queued items end up in the queue in the requested order
+	ThreadPool m_worker;
+};
+
+#endif
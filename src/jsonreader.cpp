@@ -0,0 +1,483 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "jsonreader.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// maximum nesting level of arrays and objects, protects the stack from malicious requests
+static const int MAX_DEPTH = 256;
+
+// the items of containers are collected into lists while parsing because their number is not known in advance
+struct ItemNode
+{
+    JsonValue m_value;
+    ItemNode* m_next;
+};
+
+struct MemberNode
+{
+    JsonValue::Member m_member;
+    MemberNode* m_next;
+};
+
+// =====================================================================================================================
+JsonReader::JsonReader(Arena& arena)
+    : m_arena(arena),
+      m_pos(nullptr),
+      m_end(nullptr)
+{
+}
+
+// =====================================================================================================================
+bool JsonReader::parse(const std::string& data, JsonValue& root)
+{
+    m_pos = data.data();
+    m_end = data.data() + data.size();
+
+    root = JsonValue();
+
+    if (!parseValue(root, 0))
+	return false;
+
+    skipWhitespace();
+
+    // nothing but whitespace is allowed after the document
+    return m_pos == m_end;
+}
+
+// =====================================================================================================================
+bool JsonReader::parseValue(JsonValue& value, int depth)
+{
+    skipWhitespace();
+
+    if (m_pos == m_end)
+	return false;
+
+    switch (*m_pos)
+    {
+	case '{' :
+	    return parseObject(value, depth + 1);
+
+	case '[' :
+	    return parseArray(value, depth + 1);
+
+	case '"' :
+	    value.m_type = Json::stringValue;
+	    return parseString(value.m_string.m_data, value.m_string.m_size);
+
+	case 't' :
+	    value.m_type = Json::booleanValue;
+	    value.m_bool = true;
+	    return parseLiteral("true");
+
+	case 'f' :
+	    value.m_type = Json::booleanValue;
+	    value.m_bool = false;
+	    return parseLiteral("false");
+
+	case 'n' :
+	    value.m_type = Json::nullValue;
+	    return parseLiteral("null");
+
+	default :
+	    return parseNumber(value);
+    }
+}
+
+// =====================================================================================================================
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+	return c - '0';
+    if (c >= 'a' && c <= 'f')
+	return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+	return c - 'A' + 10;
+    return -1;
+}
+
+// =====================================================================================================================
+static inline bool parseHex4(const char* p, unsigned& cp)
+{
+    cp = 0;
+
+    for (int i = 0; i < 4; ++i)
+    {
+	int v = hexValue(p[i]);
+
+	if (v < 0)
+	    return false;
+
+	cp = (cp << 4) | v;
+    }
+
+    return true;
+}
+
+// =====================================================================================================================
+static inline char* encodeUtf8(unsigned cp, char* out)
+{
+    if (cp < 0x80)
+	*out++ = cp;
+    else if (cp < 0x800)
+    {
+	*out++ = 0xc0 | (cp >> 6);
+	*out++ = 0x80 | (cp & 0x3f);
+    }
+    else if (cp < 0x10000)
+    {
+	*out++ = 0xe0 | (cp >> 12);
+	*out++ = 0x80 | ((cp >> 6) & 0x3f);
+	*out++ = 0x80 | (cp & 0x3f);
+    }
+    else
+    {
+	*out++ = 0xf0 | (cp >> 18);
+	*out++ = 0x80 | ((cp >> 12) & 0x3f);
+	*out++ = 0x80 | ((cp >> 6) & 0x3f);
+	*out++ = 0x80 | (cp & 0x3f);
+    }
+
+    return out;
+}
+
+// =====================================================================================================================
+bool JsonReader::parseString(const char*& data, size_t& size)
+{
+    // skip the opening quote
+    const char* start = ++m_pos;
+    bool escaped = false;
+
+    while (m_pos != m_end && *m_pos != '"')
+    {
+	if (static_cast<unsigned char>(*m_pos) < 0x20)
+	    return false;
+
+	if (*m_pos == '\\')
+	{
+	    escaped = true;
+
+	    if (++m_pos == m_end)
+		return false;
+	}
+
+	++m_pos;
+    }
+
+    if (m_pos == m_end)
+	return false;
+
+    const char* end = m_pos++;
+
+    if (!escaped)
+    {
+	// the common case, the string is used right from the request buffer
+	data = start;
+	size = end - start;
+	return true;
+    }
+
+    // escape sequences never produce more bytes than they take in the input
+    char* out = m_arena.allocate<char>(end - start);
+    data = out;
+
+    for (const char* p = start; p < end; ++p)
+    {
+	if (*p != '\\')
+	{
+	    *out++ = *p;
+	    continue;
+	}
+
+	switch (*++p)
+	{
+	    case '"' : *out++ = '"'; break;
+	    case '\\' : *out++ = '\\'; break;
+	    case '/' : *out++ = '/'; break;
+	    case 'b' : *out++ = '\b'; break;
+	    case 'f' : *out++ = '\f'; break;
+	    case 'n' : *out++ = '\n'; break;
+	    case 'r' : *out++ = '\r'; break;
+	    case 't' : *out++ = '\t'; break;
+
+	    case 'u' :
+	    {
+		unsigned cp;
+
+		if (end - p < 5 || !parseHex4(p + 1, cp))
+		    return false;
+
+		p += 4;
+
+		// characters outside of the basic plane are encoded as surrogate pairs
+		if (cp >= 0xd800 && cp <= 0xdbff)
+		{
+		    unsigned low;
+
+		    if (end - p < 7 || p[1] != '\\' || p[2] != 'u' || !parseHex4(p + 3, low) ||
+			low < 0xdc00 || low > 0xdfff)
+			return false;
+
+		    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+		    p += 6;
+		}
+
+		out = encodeUtf8(cp, out);
+		break;
+	    }
+
+	    default :
+		return false;
+	}
+    }
+
+    size = out - data;
+
+    return true;
+}
+
+// =====================================================================================================================
+bool JsonReader::parseNumber(JsonValue& value)
+{
+    const char* start = m_pos;
+    bool negative = false;
+
+    if (*m_pos == '-')
+    {
+	negative = true;
+	++m_pos;
+    }
+
+    if (m_pos == m_end || *m_pos < '0' || *m_pos > '9')
+	return false;
+
+    // integer part, leading zeros are not allowed
+    unsigned long long v = 0;
+    bool overflow = false;
+
+    if (*m_pos == '0')
+	++m_pos;
+    else
+    {
+	while (m_pos != m_end && *m_pos >= '0' && *m_pos <= '9')
+	{
+	    unsigned digit = *m_pos++ - '0';
+
+	    if (v > (ULLONG_MAX - digit) / 10)
+		overflow = true;
+
+	    v = v * 10 + digit;
+	}
+    }
+
+    bool real = false;
+
+    if (m_pos != m_end && *m_pos == '.')
+    {
+	real = true;
+	++m_pos;
+
+	if (m_pos == m_end || *m_pos < '0' || *m_pos > '9')
+	    return false;
+
+	while (m_pos != m_end && *m_pos >= '0' && *m_pos <= '9')
+	    ++m_pos;
+    }
+
+    if (m_pos != m_end && (*m_pos == 'e' || *m_pos == 'E'))
+    {
+	real = true;
+	++m_pos;
+
+	if (m_pos != m_end && (*m_pos == '+' || *m_pos == '-'))
+	    ++m_pos;
+
+	if (m_pos == m_end || *m_pos < '0' || *m_pos > '9')
+	    return false;
+
+	while (m_pos != m_end && *m_pos >= '0' && *m_pos <= '9')
+	    ++m_pos;
+    }
+
+    if (!real && !overflow)
+    {
+	if (!negative && v > static_cast<unsigned long long>(LLONG_MAX))
+	{
+	    value.m_type = Json::uintValue;
+	    value.m_uint = v;
+	    return true;
+	}
+
+	if (!negative || v <= static_cast<unsigned long long>(LLONG_MAX) + 1)
+	{
+	    value.m_type = Json::intValue;
+	    value.m_int = negative ? static_cast<long long>(0ULL - v) : static_cast<long long>(v);
+	    return true;
+	}
+    }
+
+    // the number was validated above, strtod stops exactly at its end because the buffer of std::string is terminated
+    value.m_type = Json::realValue;
+    value.m_real = strtod(start, nullptr);
+
+    return true;
+}
+
+// =====================================================================================================================
+bool JsonReader::parseArray(JsonValue& value, int depth)
+{
+    if (depth > MAX_DEPTH)
+	return false;
+
+    // skip the opening bracket
+    ++m_pos;
+
+    ItemNode* first = nullptr;
+    ItemNode** last = &first;
+    JsonValue::ArrayIndex count = 0;
+
+    skipWhitespace();
+
+    if (m_pos != m_end && *m_pos == ']')
+	++m_pos;
+    else
+    {
+	while (1)
+	{
+	    ItemNode* node = new (m_arena.allocate<ItemNode>(1)) ItemNode();
+
+	    if (!parseValue(node->m_value, depth))
+		return false;
+
+	    *last = node;
+	    last = &node->m_next;
+	    ++count;
+
+	    skipWhitespace();
+
+	    if (m_pos == m_end)
+		return false;
+
+	    if (*m_pos == ']')
+	    {
+		++m_pos;
+		break;
+	    }
+
+	    if (*m_pos++ != ',')
+		return false;
+	}
+    }
+
+    // move the items into a continuous array to make indexing constant time
+    JsonValue* items = m_arena.allocate<JsonValue>(count);
+
+    JsonValue::ArrayIndex i = 0;
+    for (ItemNode* node = first; i < count; node = node->m_next)
+	new (&items[i++]) JsonValue(node->m_value);
+
+    value.m_type = Json::arrayValue;
+    value.m_array.m_items = items;
+    value.m_array.m_size = count;
+
+    return true;
+}
+
+// =====================================================================================================================
+bool JsonReader::parseObject(JsonValue& value, int depth)
+{
+    if (depth > MAX_DEPTH)
+	return false;
+
+    // skip the opening brace
+    ++m_pos;
+
+    MemberNode* first = nullptr;
+    MemberNode** last = &first;
+    JsonValue::ArrayIndex count = 0;
+
+    skipWhitespace();
+
+    if (m_pos != m_end && *m_pos == '}')
+	++m_pos;
+    else
+    {
+	while (1)
+	{
+	    MemberNode* node = new (m_arena.allocate<MemberNode>(1)) MemberNode();
+
+	    skipWhitespace();
+
+	    if (m_pos == m_end || *m_pos != '"')
+		return false;
+
+	    if (!parseString(node->m_member.m_key, node->m_member.m_keySize))
+		return false;
+
+	    skipWhitespace();
+
+	    if (m_pos == m_end || *m_pos++ != ':')
+		return false;
+
+	    if (!parseValue(node->m_member.m_value, depth))
+		return false;
+
+	    *last = node;
+	    last = &node->m_next;
+	    ++count;
+
+	    skipWhitespace();
+
+	    if (m_pos == m_end)
+		return false;
+
+	    if (*m_pos == '}')
+	    {
+		++m_pos;
+		break;
+	    }
+
+	    if (*m_pos++ != ',')
+		return false;
+	}
+    }
+
+    JsonValue::Member* members = m_arena.allocate<JsonValue::Member>(count);
+
+    JsonValue::ArrayIndex i = 0;
+    for (MemberNode* node = first; i < count; node = node->m_next)
+	new (&members[i++]) JsonValue::Member(node->m_member);
+
+    value.m_type = Json::objectValue;
+    value.m_object.m_members = members;
+    value.m_object.m_size = count;
+
+    return true;
+}
+
+// =====================================================================================================================
+bool JsonReader::parseLiteral(const char* literal)
+{
+    size_t size = strlen(literal);
+
+    if (static_cast<size_t>(m_end - m_pos) < size || memcmp(m_pos, literal, size) != 0)
+	return false;
+
+    m_pos += size;
+
+    return true;
+}
+
+// =====================================================================================================================
+void JsonReader::skipWhitespace()
+{
+    while (m_pos != m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n' || *m_pos == '\r'))
+	++m_pos;
+}
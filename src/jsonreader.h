@@ -0,0 +1,42 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_JSONREADER_H_INCLUDED
+#define JSONRPCREMOTE_JSONREADER_H_INCLUDED
+
+#include "jsonvalue.h"
+#include "arena.h"
+
+/**
+ * Parses JSON documents into JsonValue trees allocated from an arena. Strings are not copied unless they contain
+ * escape sequences, the parsed buffer must outlive the produced values.
+ */
+class JsonReader
+{
+    public:
+	JsonReader(Arena& arena);
+
+	// returns false if the document is not valid JSON
+	bool parse(const std::string& data, JsonValue& root);
+
+    private:
+	bool parseValue(JsonValue& value, int depth);
+	bool parseString(const char*& data, size_t& size);
+	bool parseNumber(JsonValue& value);
+	bool parseArray(JsonValue& value, int depth);
+	bool parseObject(JsonValue& value, int depth);
+	bool parseLiteral(const char* literal);
+
+	void skipWhitespace();
+
+    private:
+	Arena& m_arena;
+
+	const char* m_pos;
+	const char* m_end;
+};
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "jsonvalue.h"
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+// =====================================================================================================================
+static const JsonValue& nullValue()
+{
+    static const JsonValue null;
+    return null;
+}
+
+// =====================================================================================================================
+JsonValue::JsonValue()
+    : m_type(Json::nullValue),
+      m_uint(0)
+{
+}
+
+// =====================================================================================================================
+bool JsonValue::isInt() const
+{
+    switch (m_type)
+    {
+	case Json::intValue :
+	    return m_int >= INT_MIN && m_int <= INT_MAX;
+	case Json::uintValue :
+	    return m_uint <= INT_MAX;
+	default :
+	    return false;
+    }
+}
+
+// =====================================================================================================================
+JsonValue::ArrayIndex JsonValue::size() const
+{
+    switch (m_type)
+    {
+	case Json::arrayValue :
+	    return m_array.m_size;
+	case Json::objectValue :
+	    return m_object.m_size;
+	default :
+	    return 0;
+    }
+}
+
+// =====================================================================================================================
+bool JsonValue::isMember(const char* key) const
+{
+    return &(*this)[key] != &nullValue();
+}
+
+// =====================================================================================================================
+const JsonValue& JsonValue::operator[](const char* key) const
+{
+    if (m_type != Json::objectValue)
+	return nullValue();
+
+    size_t keySize = strlen(key);
+
+    for (ArrayIndex i = 0; i < m_object.m_size; ++i)
+    {
+	const Member& m = m_object.m_members[i];
+
+	if (m.m_keySize == keySize && memcmp(m.m_key, key, keySize) == 0)
+	    return m.m_value;
+    }
+
+    return nullValue();
+}
+
+// =====================================================================================================================
+const JsonValue& JsonValue::operator[](ArrayIndex index) const
+{
+    if (m_type != Json::arrayValue || index >= m_array.m_size)
+	return nullValue();
+
+    return m_array.m_items[index];
+}
+
+// =====================================================================================================================
+const JsonValue::Member& JsonValue::member(ArrayIndex index) const
+{
+    if (m_type != Json::objectValue || index >= m_object.m_size)
+	throw std::runtime_error("invalid member index");
+
+    return m_object.m_members[index];
+}
+
+// =====================================================================================================================
+bool JsonValue::asBool() const
+{
+    switch (m_type)
+    {
+	case Json::nullValue :
+	    return false;
+	case Json::booleanValue :
+	    return m_bool;
+	case Json::intValue :
+	    return m_int != 0;
+	case Json::uintValue :
+	    return m_uint != 0;
+	case Json::realValue :
+	    return m_real != 0.0;
+	default :
+	    throw std::runtime_error("value is not convertible to bool");
+    }
+}
+
+// =====================================================================================================================
+int JsonValue::asInt() const
+{
+    long long v = asInt64();
+
+    if (v < INT_MIN || v > INT_MAX)
+	throw std::runtime_error("value is out of int range");
+
+    return static_cast<int>(v);
+}
+
+// =====================================================================================================================
+long long JsonValue::asInt64() const
+{
+    switch (m_type)
+    {
+	case Json::nullValue :
+	    return 0;
+	case Json::booleanValue :
+	    return m_bool ? 1 : 0;
+	case Json::intValue :
+	    return m_int;
+	case Json::uintValue :
+	    if (m_uint > LLONG_MAX)
+		break;
+	    return static_cast<long long>(m_uint);
+	case Json::realValue :
+	    if (m_real < LLONG_MIN || m_real > LLONG_MAX)
+		break;
+	    return static_cast<long long>(m_real);
+	default :
+	    break;
+    }
+
+    throw std::runtime_error("value is not convertible to int");
+}
+
+// =====================================================================================================================
+unsigned long long JsonValue::asUInt64() const
+{
+    switch (m_type)
+    {
+	case Json::nullValue :
+	    return 0;
+	case Json::booleanValue :
+	    return m_bool ? 1 : 0;
+	case Json::intValue :
+	    if (m_int < 0)
+		break;
+	    return static_cast<unsigned long long>(m_int);
+	case Json::uintValue :
+	    return m_uint;
+	case Json::realValue :
+	    if (m_real < 0 || m_real > ULLONG_MAX)
+		break;
+	    return static_cast<unsigned long long>(m_real);
+	default :
+	    break;
+    }
+
+    throw std::runtime_error("value is not convertible to unsigned int");
+}
+
+// =====================================================================================================================
+double JsonValue::asDouble() const
+{
+    switch (m_type)
+    {
+	case Json::nullValue :
+	    return 0.0;
+	case Json::booleanValue :
+	    return m_bool ? 1.0 : 0.0;
+	case Json::intValue :
+	    return m_int;
+	case Json::uintValue :
+	    return m_uint;
+	case Json::realValue :
+	    return m_real;
+	default :
+	    throw std::runtime_error("value is not convertible to double");
+    }
+}
+
+// =====================================================================================================================
+std::string JsonValue::asString() const
+{
+    switch (m_type)
+    {
+	case Json::nullValue :
+	    return "";
+	case Json::booleanValue :
+	    return m_bool ? "true" : "false";
+	case Json::intValue :
+	    return std::to_string(m_int);
+	case Json::uintValue :
+	    return std::to_string(m_uint);
+	case Json::stringValue :
+	    return std::string(m_string.m_data, m_string.m_size);
+	default :
+	    throw std::runtime_error("value is not convertible to string");
+    }
+}
+
+// =====================================================================================================================
+const char* JsonValue::stringData() const
+{
+    return m_type == Json::stringValue ? m_string.m_data : "";
+}
+
+// =====================================================================================================================
+size_t JsonValue::stringSize() const
+{
+    return m_type == Json::stringValue ? m_string.m_size : 0;
+}
+
+// =====================================================================================================================
+bool JsonValue::equals(const char* s, size_t size) const
+{
+    return m_type == Json::stringValue && m_string.m_size == size && memcmp(m_string.m_data, s, size) == 0;
+}
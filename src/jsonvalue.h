@@ -0,0 +1,115 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_JSONVALUE_H_INCLUDED
+#define JSONRPCREMOTE_JSONVALUE_H_INCLUDED
+
+#include <jsoncpp/json/value.h>
+
+#include <string>
+
+/**
+ * Read-only JSON value produced by JsonReader. The value tree lives in the arena of the request, strings without
+ * escape sequences point right into the request buffer. The interface follows Json::Value to make switching between
+ * the two easy.
+ */
+class JsonValue
+{
+    public:
+	typedef unsigned ArrayIndex;
+
+	struct Member;
+
+	JsonValue();
+
+	Json::ValueType type() const
+	{ return m_type; }
+
+	bool isNull() const
+	{ return m_type == Json::nullValue; }
+	bool isBool() const
+	{ return m_type == Json::booleanValue; }
+	bool isInt() const;
+	bool isIntegral() const
+	{ return m_type == Json::intValue || m_type == Json::uintValue; }
+	bool isString() const
+	{ return m_type == Json::stringValue; }
+	bool isArray() const
+	{ return m_type == Json::arrayValue; }
+	bool isObject() const
+	{ return m_type == Json::objectValue; }
+
+	// the number of items of an array or the number of members of an object, 0 for other types
+	ArrayIndex size() const;
+	bool empty() const
+	{ return size() == 0; }
+
+	bool isMember(const char* key) const;
+
+	// the accessors return a null value if the item does not exist
+	const JsonValue& operator[](const char* key) const;
+	const JsonValue& operator[](ArrayIndex index) const;
+
+	const Member& member(ArrayIndex index) const;
+
+	// the conversions throw std::runtime_error if the value has a different type or it is out of range
+	bool asBool() const;
+	int asInt() const;
+	long long asInt64() const;
+	unsigned long long asUInt64() const;
+	double asDouble() const;
+	std::string asString() const;
+
+	// raw access to the contents of string values
+	const char* stringData() const;
+	size_t stringSize() const;
+
+	bool equals(const char* s, size_t size) const;
+	bool equals(const std::string& s) const
+	{ return equals(s.data(), s.size()); }
+
+    private:
+	friend class JsonReader;
+	friend class MsgPackReader;
+
+	Json::ValueType m_type;
+
+	union
+	{
+	    bool m_bool;
+	    long long m_int;
+	    unsigned long long m_uint;
+	    double m_real;
+
+	    struct
+	    {
+		const char* m_data;
+		size_t m_size;
+	    } m_string;
+
+	    struct
+	    {
+		const JsonValue* m_items;
+		ArrayIndex m_size;
+	    } m_array;
+
+	    struct
+	    {
+		const Member* m_members;
+		ArrayIndex m_size;
+	    } m_object;
+	};
+};
+
+struct JsonValue::Member
+{
+    const char* m_key;
+    size_t m_keySize;
+
+    JsonValue m_value;
+};
+
+#endif
@@ -0,0 +1,222 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "jsonwriter.h"
+#include "base64.h"
+
+#include <cmath>
+#include <cstdio>
+
+// =====================================================================================================================
+JsonWriter::JsonWriter(std::string& buffer, Arena* arena)
+    : ResponseWriter(JSON, buffer, arena)
+{
+}
+
+// =====================================================================================================================
+void JsonWriter::beginObject()
+{
+    separate();
+    push(m_buffer.size());
+    m_buffer += '{';
+}
+
+// =====================================================================================================================
+void JsonWriter::endObject()
+{
+    size_t count;
+    pop(count);
+    m_buffer += '}';
+}
+
+// =====================================================================================================================
+void JsonWriter::beginArray()
+{
+    separate();
+    push(m_buffer.size());
+    m_buffer += '[';
+}
+
+// =====================================================================================================================
+void JsonWriter::endArray()
+{
+    size_t count;
+    pop(count);
+    m_buffer += ']';
+}
+
+// =====================================================================================================================
+void JsonWriter::writeKey(const char* name, size_t size)
+{
+    separate();
+    writeQuoted(name, size);
+    m_buffer += ':';
+
+    m_afterKey = true;
+}
+
+// =====================================================================================================================
+void JsonWriter::writeNull()
+{
+    separate();
+    m_buffer.append("null", 4);
+}
+
+// =====================================================================================================================
+void JsonWriter::writeBool(bool v)
+{
+    separate();
+
+    if (v)
+	m_buffer.append("true", 4);
+    else
+	m_buffer.append("false", 5);
+}
+
+// =====================================================================================================================
+void JsonWriter::writeInt(long long v)
+{
+    separate();
+
+    if (v < 0)
+	writeUnsigned(0ULL - static_cast<unsigned long long>(v), true);
+    else
+	writeUnsigned(static_cast<unsigned long long>(v), false);
+}
+
+// =====================================================================================================================
+void JsonWriter::writeUInt(unsigned long long v)
+{
+    separate();
+    writeUnsigned(v, false);
+}
+
+// =====================================================================================================================
+void JsonWriter::writeDouble(double v)
+{
+    separate();
+
+    // JSON has no representation for NaN and infinity
+    if (!std::isfinite(v))
+    {
+	m_buffer.append("null", 4);
+	return;
+    }
+
+    char tmp[32];
+    int len = snprintf(tmp, sizeof(tmp), "%.17g", v);
+
+    // the decimal point of the C locale may be any (even multibyte) character, it is always written as '.'
+    bool point = false;
+
+    for (int i = 0; i < len; ++i)
+    {
+	char c = tmp[i];
+
+	if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == 'e')
+	    m_buffer += c;
+	else if (!point)
+	{
+	    m_buffer += '.';
+	    point = true;
+	}
+    }
+}
+
+// =====================================================================================================================
+void JsonWriter::writeBinary(const unsigned char* data, size_t size)
+{
+    separate();
+
+    m_buffer.reserve(m_buffer.size() + Base64::encodedSize(size) + 2);
+
+    m_buffer += '"';
+    Base64::encode(data, size, m_buffer);
+    m_buffer += '"';
+}
+
+// =====================================================================================================================
+void JsonWriter::writeRaw(const std::string& data)
+{
+    separate();
+    m_buffer.append(data);
+}
+
+// =====================================================================================================================
+void JsonWriter::separate()
+{
+    // the separator is needed before every item of a container except the first one
+    if (nextItem() && m_count > 1)
+	m_buffer += ',';
+}
+
+// =====================================================================================================================
+void JsonWriter::writeString(const char* s, size_t size)
+{
+    separate();
+    writeQuoted(s, size);
+}
+
+// =====================================================================================================================
+void JsonWriter::writeQuoted(const char* s, size_t size)
+{
+    static const char* hex = "0123456789abcdef";
+
+    m_buffer.reserve(m_buffer.size() + size + 2);
+    m_buffer += '"';
+
+    size_t start = 0;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+	unsigned char c = s[i];
+
+	if (c >= 0x20 && c != '"' && c != '\\')
+	    continue;
+
+	// flush the part that does not need escaping
+	m_buffer.append(s + start, i - start);
+	start = i + 1;
+
+	switch (c)
+	{
+	    case '"' : m_buffer.append("\\\"", 2); break;
+	    case '\\' : m_buffer.append("\\\\", 2); break;
+	    case '\b' : m_buffer.append("\\b", 2); break;
+	    case '\f' : m_buffer.append("\\f", 2); break;
+	    case '\n' : m_buffer.append("\\n", 2); break;
+	    case '\r' : m_buffer.append("\\r", 2); break;
+	    case '\t' : m_buffer.append("\\t", 2); break;
+	    default :
+	    {
+		char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+		m_buffer.append(esc, 6);
+		break;
+	    }
+	}
+    }
+
+    m_buffer.append(s + start, size - start);
+    m_buffer += '"';
+}
+
+// =====================================================================================================================
+void JsonWriter::writeUnsigned(unsigned long long v, bool negative)
+{
+    char tmp[24];
+    char* p = tmp + sizeof(tmp);
+
+    do
+    {
+	*--p = '0' + (v % 10);
+	v /= 10;
+    } while (v != 0);
+
+    if (negative)
+	*--p = '-';
+
+    m_buffer.append(p, tmp + sizeof(tmp) - p);
+}
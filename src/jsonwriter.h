@@ -0,0 +1,47 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_JSONWRITER_H_INCLUDED
+#define JSONRPCREMOTE_JSONWRITER_H_INCLUDED
+
+#include "responsewriter.h"
+
+/**
+ * Writes the response as JSON text, binary data is encoded with base64.
+ */
+class JsonWriter : public ResponseWriter
+{
+    public:
+	JsonWriter(std::string& buffer, Arena* arena = nullptr);
+
+	void beginObject() override;
+	void endObject() override;
+
+	void beginArray() override;
+	void endArray() override;
+
+    protected:
+	void writeKey(const char* name, size_t size) override;
+	void writeNull() override;
+	void writeBool(bool v) override;
+	void writeInt(long long v) override;
+	void writeUInt(unsigned long long v) override;
+	void writeDouble(double v) override;
+	void writeString(const char* s, size_t size) override;
+	void writeBinary(const unsigned char* data, size_t size) override;
+	void writeRaw(const std::string& data) override;
+
+    private:
+	// called before every value and key to emit the separator between the items of a container
+	void separate();
+
+	// writes a string with the quotes and the escape sequences
+	void writeQuoted(const char* s, size_t size);
+
+	void writeUnsigned(unsigned long long v, bool negative);
+};
+
+#endif
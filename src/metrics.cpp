@@ -0,0 +1,256 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+
+const unsigned long long Metrics::s_buckets[] = {
+    50, 100, 250, 500,
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 30000000, 60000000
+};
+
+// one more bucket for the calls slower than the last bound
+const size_t Metrics::BUCKET_COUNT = sizeof(s_buckets) / sizeof(s_buckets[0]) + 1;
+
+// =====================================================================================================================
+Metrics::Method::Method()
+    : m_calls(0),
+      m_errors(0),
+      m_responseBytes(0),
+      m_latencySumUs(0),
+      m_latency(new std::atomic<unsigned long long>[BUCKET_COUNT])
+{
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+	m_latency[i] = 0;
+}
+
+// =====================================================================================================================
+Metrics::Requests::Requests()
+    : m_count(0),
+      m_requestBytes(0),
+      m_responseBytes(0)
+{
+}
+
+// =====================================================================================================================
+Metrics::Metrics(const std::vector<const char*>& methods)
+    : m_names(methods),
+      m_methods(new Method[methods.size()]),
+      m_invalidCalls(0)
+{
+}
+
+// =====================================================================================================================
+void Metrics::recordCall(size_t method, unsigned long long latencyUs, size_t responseBytes, bool error)
+{
+    Method& m = m_methods[method];
+
+    size_t bucket = std::lower_bound(s_buckets, s_buckets + BUCKET_COUNT - 1, latencyUs) - s_buckets;
+
+    m.m_calls.fetch_add(1, std::memory_order_relaxed);
+    m.m_responseBytes.fetch_add(responseBytes, std::memory_order_relaxed);
+    m.m_latencySumUs.fetch_add(latencyUs, std::memory_order_relaxed);
+    m.m_latency[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    if (error)
+	m.m_errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+// =====================================================================================================================
+void Metrics::recordInvalidCall()
+{
+    m_invalidCalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+// =====================================================================================================================
+void Metrics::recordRequest(ResponseWriter::Format format, size_t requestBytes, size_t responseBytes)
+{
+    Requests& r = m_requests[format];
+
+    r.m_count.fetch_add(1, std::memory_order_relaxed);
+    r.m_requestBytes.fetch_add(requestBytes, std::memory_order_relaxed);
+    r.m_responseBytes.fetch_add(responseBytes, std::memory_order_relaxed);
+}
+
+// =====================================================================================================================
+void Metrics::write(ResponseWriter& response) const
+{
+    response.beginObject();
+
+    // only the methods called at least once are listed to keep the result small
+    response.key("methods");
+    response.beginObject();
+
+    for (size_t i = 0; i < m_names.size(); ++i)
+    {
+	const Method& m = m_methods[i];
+
+	if (m.m_calls == 0)
+	    continue;
+
+	response.key(m_names[i]);
+	response.beginObject();
+	response.member("calls", m.m_calls.load());
+	response.member("errors", m.m_errors.load());
+	response.member("response_bytes", m.m_responseBytes.load());
+	response.member("latency_sum_us", m.m_latencySumUs.load());
+
+	// the number of calls in each bucket, the last one counts the calls slower than every bound
+	response.key("latency_us");
+	response.beginArray();
+	for (size_t b = 0; b < BUCKET_COUNT; ++b)
+	{
+	    response.beginArray();
+	    if (b < BUCKET_COUNT - 1)
+		response.value(s_buckets[b]);
+	    else
+		response.null();
+	    response.value(m.m_latency[b].load());
+	    response.endArray();
+	}
+	response.endArray();
+
+	response.endObject();
+    }
+
+    response.endObject();
+
+    response.member("invalid_calls", m_invalidCalls.load());
+
+    response.key("requests");
+    response.beginObject();
+
+    for (int f = 0; f < ResponseWriter::FORMAT_COUNT; ++f)
+    {
+	const Requests& r = m_requests[f];
+
+	response.key(formatName(static_cast<ResponseWriter::Format>(f)));
+	response.beginObject();
+	response.member("count", r.m_count.load());
+	response.member("request_bytes", r.m_requestBytes.load());
+	response.member("response_bytes", r.m_responseBytes.load());
+	response.endObject();
+    }
+
+    response.endObject();
+
+    response.endObject();
+}
+
+// =====================================================================================================================
+template<typename T>
+static void appendLine(std::string& output, const char* name, const char* labels, T value)
+{
+    output += name;
+    output += labels;
+    output += ' ';
+    output += std::to_string(value);
+    output += '\n';
+}
+
+// =====================================================================================================================
+void Metrics::writePrometheus(std::string& output) const
+{
+    char labels[256];
+
+    output += "# HELP jsonrpc_calls_total Number of calls of the RPC methods.\n";
+    output += "# TYPE jsonrpc_calls_total counter\n";
+    for (size_t i = 0; i < m_names.size(); ++i)
+    {
+	snprintf(labels, sizeof(labels), "{method=\"%s\"}", m_names[i]);
+	appendLine(output, "jsonrpc_calls_total", labels, m_methods[i].m_calls.load());
+    }
+
+    output += "# HELP jsonrpc_call_errors_total Number of calls of the RPC methods failed with an error.\n";
+    output += "# TYPE jsonrpc_call_errors_total counter\n";
+    for (size_t i = 0; i < m_names.size(); ++i)
+    {
+	snprintf(labels, sizeof(labels), "{method=\"%s\"}", m_names[i]);
+	appendLine(output, "jsonrpc_call_errors_total", labels, m_methods[i].m_errors.load());
+    }
+
+    output += "# HELP jsonrpc_call_response_bytes_total Size of the replies of the RPC methods.\n";
+    output += "# TYPE jsonrpc_call_response_bytes_total counter\n";
+    for (size_t i = 0; i < m_names.size(); ++i)
+    {
+	snprintf(labels, sizeof(labels), "{method=\"%s\"}", m_names[i]);
+	appendLine(output, "jsonrpc_call_response_bytes_total", labels, m_methods[i].m_responseBytes.load());
+    }
+
+    output += "# HELP jsonrpc_call_duration_seconds Execution time of the RPC methods.\n";
+    output += "# TYPE jsonrpc_call_duration_seconds histogram\n";
+    for (size_t i = 0; i < m_names.size(); ++i)
+    {
+	const Method& m = m_methods[i];
+	unsigned long long cumulative = 0;
+
+	for (size_t b = 0; b < BUCKET_COUNT; ++b)
+	{
+	    cumulative += m.m_latency[b].load();
+
+	    if (b < BUCKET_COUNT - 1)
+		snprintf(labels, sizeof(labels), "{method=\"%s\",le=\"%g\"}", m_names[i], s_buckets[b] / 1e6);
+	    else
+		snprintf(labels, sizeof(labels), "{method=\"%s\",le=\"+Inf\"}", m_names[i]);
+
+	    appendLine(output, "jsonrpc_call_duration_seconds_bucket", labels, cumulative);
+	}
+
+	snprintf(labels, sizeof(labels), "{method=\"%s\"}", m_names[i]);
+	output += "jsonrpc_call_duration_seconds_sum";
+	output += labels;
+	snprintf(labels, sizeof(labels), " %.6f\n", m.m_latencySumUs.load() / 1e6);
+	output += labels;
+
+	snprintf(labels, sizeof(labels), "{method=\"%s\"}", m_names[i]);
+	appendLine(output, "jsonrpc_call_duration_seconds_count", labels, cumulative);
+    }
+
+    output += "# HELP jsonrpc_invalid_calls_total Number of calls without a valid method.\n";
+    output += "# TYPE jsonrpc_invalid_calls_total counter\n";
+    appendLine(output, "jsonrpc_invalid_calls_total", "", m_invalidCalls.load());
+
+    output += "# HELP jsonrpc_requests_total Number of HTTP requests.\n";
+    output += "# TYPE jsonrpc_requests_total counter\n";
+    for (int f = 0; f < ResponseWriter::FORMAT_COUNT; ++f)
+    {
+	snprintf(labels, sizeof(labels), "{format=\"%s\"}", formatName(static_cast<ResponseWriter::Format>(f)));
+	appendLine(output, "jsonrpc_requests_total", labels, m_requests[f].m_count.load());
+    }
+
+    output += "# HELP jsonrpc_request_bytes_total Size of the bodies of HTTP requests.\n";
+    output += "# TYPE jsonrpc_request_bytes_total counter\n";
+    for (int f = 0; f < ResponseWriter::FORMAT_COUNT; ++f)
+    {
+	snprintf(labels, sizeof(labels), "{format=\"%s\"}", formatName(static_cast<ResponseWriter::Format>(f)));
+	appendLine(output, "jsonrpc_request_bytes_total", labels, m_requests[f].m_requestBytes.load());
+    }
+
+    output += "# HELP jsonrpc_response_bytes_total Size of the bodies of HTTP responses before compression.\n";
+    output += "# TYPE jsonrpc_response_bytes_total counter\n";
+    for (int f = 0; f < ResponseWriter::FORMAT_COUNT; ++f)
+    {
+	snprintf(labels, sizeof(labels), "{format=\"%s\"}", formatName(static_cast<ResponseWriter::Format>(f)));
+	appendLine(output, "jsonrpc_response_bytes_total", labels, m_requests[f].m_responseBytes.load());
+    }
+}
+
+// =====================================================================================================================
+const char* Metrics::formatName(ResponseWriter::Format format)
+{
+    switch (format)
+    {
+	case ResponseWriter::JSON :
+	    return "json";
+	case ResponseWriter::MSGPACK :
+	    return "msgpack";
+	default :
+	    return "";
+    }
+}
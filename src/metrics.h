@@ -0,0 +1,74 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_METRICS_H_INCLUDED
+#define JSONRPCREMOTE_METRICS_H_INCLUDED
+
+#include "responsewriter.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Call counters and latency histograms of the RPC methods. The counters are updated without locking from every
+ * thread executing calls, reading them while calls are running may give slightly inconsistent values.
+ */
+class Metrics
+{
+    public:
+	// upper bounds of the latency histogram buckets in microseconds, the last bucket is unbounded
+	static const unsigned long long s_buckets[];
+	static const size_t BUCKET_COUNT;
+
+	Metrics(const std::vector<const char*>& methods);
+
+	// records a call of the method with the given index in the list passed to the constructor
+	void recordCall(size_t method, unsigned long long latencyUs, size_t responseBytes, bool error);
+	// records a call that could not be dispatched to any method
+	void recordInvalidCall();
+	// records an HTTP request carrying one or more calls
+	void recordRequest(ResponseWriter::Format format, size_t requestBytes, size_t responseBytes);
+
+	void write(ResponseWriter& response) const;
+	// writes the metrics in the text exposition format of Prometheus
+	void writePrometheus(std::string& output) const;
+
+    private:
+	struct Method
+	{
+	    Method();
+
+	    std::atomic<unsigned long long> m_calls;
+	    std::atomic<unsigned long long> m_errors;
+	    std::atomic<unsigned long long> m_responseBytes;
+	    std::atomic<unsigned long long> m_latencySumUs;
+	    // number of calls in each bucket, not cumulative
+	    std::unique_ptr<std::atomic<unsigned long long>[]> m_latency;
+	};
+
+	struct Requests
+	{
+	    Requests();
+
+	    std::atomic<unsigned long long> m_count;
+	    std::atomic<unsigned long long> m_requestBytes;
+	    std::atomic<unsigned long long> m_responseBytes;
+	};
+
+	static const char* formatName(ResponseWriter::Format format);
+
+    private:
+	std::vector<const char*> m_names;
+	std::unique_ptr<Method[]> m_methods;
+
+	std::atomic<unsigned long long> m_invalidCalls;
+
+	Requests m_requests[ResponseWriter::FORMAT_COUNT];
+};
+
+#endif
@@ -0,0 +1,277 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "msgpackreader.h"
+
+#include <climits>
+#include <cstring>
+#include <new>
+
+// maximum nesting level of arrays and maps, protects the stack from malicious requests
+static const int MAX_DEPTH = 256;
+
+// =====================================================================================================================
+MsgPackReader::MsgPackReader(Arena& arena)
+    : m_arena(arena),
+      m_pos(nullptr),
+      m_end(nullptr)
+{
+}
+
+// =====================================================================================================================
+bool MsgPackReader::parse(const std::string& data, JsonValue& root)
+{
+    m_pos = reinterpret_cast<const unsigned char*>(data.data());
+    m_end = m_pos + data.size();
+
+    root = JsonValue();
+
+    if (!parseValue(root, 0))
+	return false;
+
+    // nothing is allowed after the document
+    return m_pos == m_end;
+}
+
+// =====================================================================================================================
+bool MsgPackReader::parseValue(JsonValue& value, int depth)
+{
+    if (m_pos == m_end)
+	return false;
+
+    uint8_t type = *m_pos++;
+    uint64_t v;
+
+    // fixed size types storing their value or size in the type byte
+    if (type <= 0x7f)
+    {
+	value.m_type = Json::intValue;
+	value.m_int = type;
+	return true;
+    }
+
+    if (type >= 0xe0)
+    {
+	value.m_type = Json::intValue;
+	value.m_int = static_cast<int8_t>(type);
+	return true;
+    }
+
+    if ((type & 0xf0) == 0x80)
+	return parseMap(type & 0x0f, value, depth + 1);
+
+    if ((type & 0xf0) == 0x90)
+	return parseArray(type & 0x0f, value, depth + 1);
+
+    if ((type & 0xe0) == 0xa0)
+    {
+	value.m_type = Json::stringValue;
+	return parseString(type & 0x1f, value.m_string.m_data, value.m_string.m_size);
+    }
+
+    switch (type)
+    {
+	case 0xc0 :
+	    value.m_type = Json::nullValue;
+	    return true;
+
+	case 0xc2 :
+	case 0xc3 :
+	    value.m_type = Json::booleanValue;
+	    value.m_bool = type == 0xc3;
+	    return true;
+
+	// binary data is handled as a string, it is up to the method to interpret its contents
+	case 0xc4 :
+	case 0xc5 :
+	case 0xc6 :
+	case 0xd9 :
+	case 0xda :
+	case 0xdb :
+	{
+	    static const size_t sizes[] = {1, 2, 4};
+	    size_t sizeBytes = sizes[type >= 0xd9 ? type - 0xd9 : type - 0xc4];
+
+	    if (!read(sizeBytes, v))
+		return false;
+
+	    value.m_type = Json::stringValue;
+	    return parseString(v, value.m_string.m_data, value.m_string.m_size);
+	}
+
+	case 0xca :
+	{
+	    if (!read(4, v))
+		return false;
+
+	    uint32_t bits = v;
+	    float f;
+	    memcpy(&f, &bits, sizeof(f));
+
+	    value.m_type = Json::realValue;
+	    value.m_real = f;
+	    return true;
+	}
+
+	case 0xcb :
+	{
+	    if (!read(8, v))
+		return false;
+
+	    double d;
+	    memcpy(&d, &v, sizeof(d));
+
+	    value.m_type = Json::realValue;
+	    value.m_real = d;
+	    return true;
+	}
+
+	case 0xcc :
+	case 0xcd :
+	case 0xce :
+	case 0xcf :
+	    if (!read(1 << (type - 0xcc), v))
+		return false;
+
+	    // unsigned integers are stored the same way as JsonReader does it
+	    if (v > static_cast<uint64_t>(LLONG_MAX))
+	    {
+		value.m_type = Json::uintValue;
+		value.m_uint = v;
+	    }
+	    else
+	    {
+		value.m_type = Json::intValue;
+		value.m_int = v;
+	    }
+	    return true;
+
+	case 0xd0 :
+	    if (!read(1, v))
+		return false;
+	    value.m_type = Json::intValue;
+	    value.m_int = static_cast<int8_t>(v);
+	    return true;
+
+	case 0xd1 :
+	    if (!read(2, v))
+		return false;
+	    value.m_type = Json::intValue;
+	    value.m_int = static_cast<int16_t>(v);
+	    return true;
+
+	case 0xd2 :
+	    if (!read(4, v))
+		return false;
+	    value.m_type = Json::intValue;
+	    value.m_int = static_cast<int32_t>(v);
+	    return true;
+
+	case 0xd3 :
+	    if (!read(8, v))
+		return false;
+	    value.m_type = Json::intValue;
+	    value.m_int = static_cast<int64_t>(v);
+	    return true;
+
+	case 0xdc :
+	case 0xdd :
+	    if (!read(type == 0xdc ? 2 : 4, v))
+		return false;
+	    return parseArray(v, value, depth + 1);
+
+	case 0xde :
+	case 0xdf :
+	    if (!read(type == 0xde ? 2 : 4, v))
+		return false;
+	    return parseMap(v, value, depth + 1);
+    }
+
+    // extension types and the unused type byte
+    return false;
+}
+
+// =====================================================================================================================
+bool MsgPackReader::parseString(size_t size, const char*& data, size_t& stringSize)
+{
+    if (static_cast<size_t>(m_end - m_pos) < size)
+	return false;
+
+    data = reinterpret_cast<const char*>(m_pos);
+    stringSize = size;
+
+    m_pos += size;
+
+    return true;
+}
+
+// =====================================================================================================================
+bool MsgPackReader::parseArray(size_t size, JsonValue& value, int depth)
+{
+    // every item takes at least one byte, this keeps bogus sizes from allocating huge arrays
+    if (depth > MAX_DEPTH || static_cast<size_t>(m_end - m_pos) < size)
+	return false;
+
+    JsonValue* items = m_arena.allocate<JsonValue>(size);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+	new (&items[i]) JsonValue();
+
+	if (!parseValue(items[i], depth))
+	    return false;
+    }
+
+    value.m_type = Json::arrayValue;
+    value.m_array.m_items = items;
+    value.m_array.m_size = size;
+
+    return true;
+}
+
+// =====================================================================================================================
+bool MsgPackReader::parseMap(size_t size, JsonValue& value, int depth)
+{
+    if (depth > MAX_DEPTH || static_cast<size_t>(m_end - m_pos) < size * 2)
+	return false;
+
+    JsonValue::Member* members = m_arena.allocate<JsonValue::Member>(size);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+	JsonValue::Member* m = new (&members[i]) JsonValue::Member();
+	JsonValue key;
+
+	if (!parseValue(key, depth) || !key.isString())
+	    return false;
+
+	m->m_key = key.stringData();
+	m->m_keySize = key.stringSize();
+
+	if (!parseValue(m->m_value, depth))
+	    return false;
+    }
+
+    value.m_type = Json::objectValue;
+    value.m_object.m_members = members;
+    value.m_object.m_size = size;
+
+    return true;
+}
+
+// =====================================================================================================================
+bool MsgPackReader::read(size_t size, uint64_t& v)
+{
+    if (static_cast<size_t>(m_end - m_pos) < size)
+	return false;
+
+    v = 0;
+
+    for (size_t i = 0; i < size; ++i)
+	v = (v << 8) | *m_pos++;
+
+    return true;
+}
@@ -0,0 +1,44 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_MSGPACKREADER_H_INCLUDED
+#define JSONRPCREMOTE_MSGPACKREADER_H_INCLUDED
+
+#include "jsonvalue.h"
+#include "arena.h"
+
+#include <cstdint>
+
+/**
+ * Parses MessagePack documents into the same JsonValue trees JsonReader produces, the method handlers do not have to
+ * know the format of the request. Strings and binary data are not copied, the parsed buffer must outlive the values.
+ * Map keys have to be strings, extension types are not supported.
+ */
+class MsgPackReader
+{
+    public:
+	MsgPackReader(Arena& arena);
+
+	// returns false if the document is not valid or it contains types without a JSON equivalent
+	bool parse(const std::string& data, JsonValue& root);
+
+    private:
+	bool parseValue(JsonValue& value, int depth);
+	bool parseString(size_t size, const char*& data, size_t& stringSize);
+	bool parseArray(size_t size, JsonValue& value, int depth);
+	bool parseMap(size_t size, JsonValue& value, int depth);
+
+	// reads a big endian number of the given size
+	bool read(size_t size, uint64_t& v);
+
+    private:
+	Arena& m_arena;
+
+	const unsigned char* m_pos;
+	const unsigned char* m_end;
+};
+
+#endif
@@ -0,0 +1,236 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "msgpackwriter.h"
+
+#include <cstring>
+
+// size of the header reserved for maps and arrays, the type byte followed by a 32 bit item count
+static const size_t CONTAINER_HEADER_SIZE = 5;
+
+// =====================================================================================================================
+MsgPackWriter::MsgPackWriter(std::string& buffer, Arena* arena)
+    : ResponseWriter(MSGPACK, buffer, arena)
+{
+}
+
+// =====================================================================================================================
+void MsgPackWriter::beginObject()
+{
+    beginContainer();
+}
+
+// =====================================================================================================================
+void MsgPackWriter::endObject()
+{
+    endContainer(0x80, 0xde, 0xdf);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::beginArray()
+{
+    beginContainer();
+}
+
+// =====================================================================================================================
+void MsgPackWriter::endArray()
+{
+    endContainer(0x90, 0xdc, 0xdd);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeKey(const char* name, size_t size)
+{
+    nextItem();
+    writeStr(name, size);
+
+    m_afterKey = true;
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeNull()
+{
+    nextItem();
+    m_buffer += static_cast<char>(0xc0);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeBool(bool v)
+{
+    nextItem();
+    m_buffer += static_cast<char>(v ? 0xc3 : 0xc2);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeInt(long long v)
+{
+    if (v >= 0)
+    {
+	writeUInt(v);
+	return;
+    }
+
+    nextItem();
+
+    if (v >= -32)
+	m_buffer += static_cast<char>(v);
+    else if (v >= INT8_MIN)
+	put8(0xd0, static_cast<uint8_t>(v));
+    else if (v >= INT16_MIN)
+	put16(0xd1, static_cast<uint16_t>(v));
+    else if (v >= INT32_MIN)
+	put32(0xd2, static_cast<uint32_t>(v));
+    else
+	put64(0xd3, static_cast<uint64_t>(v));
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeUInt(unsigned long long v)
+{
+    nextItem();
+
+    if (v < 0x80)
+	m_buffer += static_cast<char>(v);
+    else if (v <= UINT8_MAX)
+	put8(0xcc, v);
+    else if (v <= UINT16_MAX)
+	put16(0xcd, v);
+    else if (v <= UINT32_MAX)
+	put32(0xce, v);
+    else
+	put64(0xcf, v);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeDouble(double v)
+{
+    nextItem();
+
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+
+    put64(0xcb, bits);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeString(const char* s, size_t size)
+{
+    nextItem();
+    writeStr(s, size);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeBinary(const unsigned char* data, size_t size)
+{
+    nextItem();
+
+    // the data is sent as is, this is the main advantage of the format for pictures
+    if (size <= UINT8_MAX)
+	put8(0xc4, size);
+    else if (size <= UINT16_MAX)
+	put16(0xc5, size);
+    else
+	put32(0xc6, size);
+
+    m_buffer.append(reinterpret_cast<const char*>(data), size);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeRaw(const std::string& data)
+{
+    nextItem();
+    m_buffer.append(data);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::beginContainer()
+{
+    nextItem();
+    push(m_buffer.size());
+    m_buffer.append(CONTAINER_HEADER_SIZE, '\0');
+}
+
+// =====================================================================================================================
+void MsgPackWriter::endContainer(uint8_t fixType, uint8_t type16, uint8_t type32)
+{
+    size_t count;
+    size_t position = pop(count);
+
+    char* header = &m_buffer[position];
+
+    // the reserved header is replaced with the smallest one able to hold the number of items, the contents of the
+    // container are moved backwards if needed
+    if (count <= 15)
+    {
+	header[0] = fixType | count;
+	m_buffer.erase(position + 1, CONTAINER_HEADER_SIZE - 1);
+    }
+    else if (count <= UINT16_MAX)
+    {
+	header[0] = type16;
+	header[1] = count >> 8;
+	header[2] = count;
+	m_buffer.erase(position + 3, CONTAINER_HEADER_SIZE - 3);
+    }
+    else
+    {
+	header[0] = type32;
+	header[1] = count >> 24;
+	header[2] = count >> 16;
+	header[3] = count >> 8;
+	header[4] = count;
+    }
+}
+
+// =====================================================================================================================
+void MsgPackWriter::writeStr(const char* s, size_t size)
+{
+    if (size <= 31)
+	m_buffer += static_cast<char>(0xa0 | size);
+    else if (size <= UINT8_MAX)
+	put8(0xd9, size);
+    else if (size <= UINT16_MAX)
+	put16(0xda, size);
+    else
+	put32(0xdb, size);
+
+    m_buffer.append(s, size);
+}
+
+// =====================================================================================================================
+void MsgPackWriter::put8(uint8_t type, uint8_t v)
+{
+    char tmp[2] = {static_cast<char>(type), static_cast<char>(v)};
+    m_buffer.append(tmp, sizeof(tmp));
+}
+
+// =====================================================================================================================
+void MsgPackWriter::put16(uint8_t type, uint16_t v)
+{
+    char tmp[3] = {static_cast<char>(type), static_cast<char>(v >> 8), static_cast<char>(v)};
+    m_buffer.append(tmp, sizeof(tmp));
+}
+
+// =====================================================================================================================
+void MsgPackWriter::put32(uint8_t type, uint32_t v)
+{
+    char tmp[5] = {
+	static_cast<char>(type),
+	static_cast<char>(v >> 24), static_cast<char>(v >> 16), static_cast<char>(v >> 8), static_cast<char>(v)
+    };
+    m_buffer.append(tmp, sizeof(tmp));
+}
+
+// =====================================================================================================================
+void MsgPackWriter::put64(uint8_t type, uint64_t v)
+{
+    char tmp[9] = {
+	static_cast<char>(type),
+	static_cast<char>(v >> 56), static_cast<char>(v >> 48), static_cast<char>(v >> 40), static_cast<char>(v >> 32),
+	static_cast<char>(v >> 24), static_cast<char>(v >> 16), static_cast<char>(v >> 8), static_cast<char>(v)
+    };
+    m_buffer.append(tmp, sizeof(tmp));
+}
@@ -0,0 +1,52 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_MSGPACKWRITER_H_INCLUDED
+#define JSONRPCREMOTE_MSGPACKWRITER_H_INCLUDED
+
+#include "responsewriter.h"
+
+#include <cstdint>
+
+/**
+ * Writes the response in MessagePack format. The number of items of maps and arrays is not known when they are
+ * started, so a 32 bit header is reserved and it is shrunk to the smallest possible one when the container ends.
+ */
+class MsgPackWriter : public ResponseWriter
+{
+    public:
+	MsgPackWriter(std::string& buffer, Arena* arena = nullptr);
+
+	void beginObject() override;
+	void endObject() override;
+
+	void beginArray() override;
+	void endArray() override;
+
+    protected:
+	void writeKey(const char* name, size_t size) override;
+	void writeNull() override;
+	void writeBool(bool v) override;
+	void writeInt(long long v) override;
+	void writeUInt(unsigned long long v) override;
+	void writeDouble(double v) override;
+	void writeString(const char* s, size_t size) override;
+	void writeBinary(const unsigned char* data, size_t size) override;
+	void writeRaw(const std::string& data) override;
+
+    private:
+	void beginContainer();
+	void endContainer(uint8_t fixType, uint8_t type16, uint8_t type32);
+
+	void writeStr(const char* s, size_t size);
+
+	void put8(uint8_t type, uint8_t v);
+	void put16(uint8_t type, uint16_t v);
+	void put32(uint8_t type, uint32_t v);
+	void put64(uint8_t type, uint64_t v);
+};
+
+#endif
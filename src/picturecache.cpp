@@ -0,0 +1,93 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "picturecache.h"
+
+#include <iterator>
+
+// bookkeeping cost accounted for every entry, this keeps the number of albums without pictures bounded as well
+static const size_t ENTRY_OVERHEAD = 64;
+
+// =====================================================================================================================
+PictureCache::PictureCache(size_t capacity)
+    : m_capacity(capacity),
+      m_size(0)
+{
+}
+
+// =====================================================================================================================
+void PictureCache::setCapacity(size_t capacity)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_capacity = capacity;
+    shrink();
+}
+
+// =====================================================================================================================
+std::shared_ptr<const PictureCache::Pictures> PictureCache::get(int albumId, unsigned long long generation)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(albumId);
+
+    if (it == m_index.end())
+	return nullptr;
+
+    // the library has changed since the pictures were loaded
+    if (it->second->m_generation != generation)
+    {
+	erase(it->second);
+	return nullptr;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+    return it->second->m_pictures;
+}
+
+// =====================================================================================================================
+void PictureCache::put(int albumId, unsigned long long generation, const std::shared_ptr<const Pictures>& pictures)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(albumId);
+
+    if (it != m_index.end())
+	erase(it->second);
+
+    m_entries.push_front(Entry(albumId, generation, pictures));
+    m_index[albumId] = m_entries.begin();
+    m_size += entrySize(*pictures);
+
+    shrink();
+}
+
+// =====================================================================================================================
+size_t PictureCache::entrySize(const Pictures& pictures)
+{
+    size_t size = ENTRY_OVERHEAD;
+
+    for (const auto& p : pictures)
+	size += p.size();
+
+    return size;
+}
+
+// =====================================================================================================================
+void PictureCache::shrink()
+{
+    while (m_size > m_capacity && !m_entries.empty())
+	erase(std::prev(m_entries.end()));
+}
+
+// =====================================================================================================================
+void PictureCache::erase(std::list<Entry>::iterator entry)
+{
+    m_size -= entrySize(*entry->m_pictures);
+    m_index.erase(entry->m_albumId);
+    m_entries.erase(entry);
+}
@@ -0,0 +1,66 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_PICTURECACHE_H_INCLUDED
+#define JSONRPCREMOTE_PICTURECACHE_H_INCLUDED
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Size bounded LRU cache of the serialized pictures of albums. Every album is stored with the JSON objects of all of
+ * its picture types (an empty list for albums without pictures) because the storage returns them together as well.
+ * Entries are tagged with the generation of the library they were loaded in, entries of other generations are
+ * treated as missing and dropped when they are found.
+ */
+class PictureCache
+{
+    public:
+	typedef std::vector<std::string> Pictures;
+
+	PictureCache(size_t capacity);
+
+	void setCapacity(size_t capacity);
+
+	// returns nullptr if the album is not in the cache or it was stored in a different generation
+	std::shared_ptr<const Pictures> get(int albumId, unsigned long long generation);
+	void put(int albumId, unsigned long long generation, const std::shared_ptr<const Pictures>& pictures);
+
+    private:
+	static size_t entrySize(const Pictures& pictures);
+
+	// drops the least recently used entries until the cache fits into its capacity
+	void shrink();
+
+    private:
+	struct Entry
+	{
+	    Entry(int albumId, unsigned long long generation, const std::shared_ptr<const Pictures>& pictures)
+		: m_albumId(albumId), m_generation(generation), m_pictures(pictures)
+	    {}
+
+	    int m_albumId;
+	    unsigned long long m_generation;
+	    std::shared_ptr<const Pictures> m_pictures;
+	};
+
+	void erase(std::list<Entry>::iterator entry);
+
+	size_t m_capacity;
+	size_t m_size;
+
+	// the most recently used entry is at the front
+	std::list<Entry> m_entries;
+	std::unordered_map<int, std::list<Entry>::iterator> m_index;
+
+	std::mutex m_mutex;
+};
+
+#endif
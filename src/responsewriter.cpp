@@ -0,0 +1,157 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "responsewriter.h"
+#include "jsonwriter.h"
+#include "msgpackwriter.h"
+
+// =====================================================================================================================
+ResponseWriter::ResponseWriter(Format format, std::string& buffer, Arena* arena)
+    : m_buffer(buffer),
+      m_count(0),
+      m_afterKey(false),
+      m_format(format),
+      m_stack(ArenaAllocator<Container>(arena))
+{
+}
+
+// =====================================================================================================================
+std::unique_ptr<ResponseWriter> ResponseWriter::create(Format format, std::string& buffer)
+{
+    switch (format)
+    {
+	case MSGPACK :
+	    return std::unique_ptr<ResponseWriter>(new MsgPackWriter(buffer));
+
+	case JSON :
+	default :
+	    return std::unique_ptr<ResponseWriter>(new JsonWriter(buffer));
+    }
+}
+
+// =====================================================================================================================
+ResponseWriter::ArenaPtr ResponseWriter::create(Format format, std::string& buffer, Arena& arena, bool stackInArena)
+{
+    Arena* stackArena = stackInArena ? &arena : nullptr;
+
+    switch (format)
+    {
+	case MSGPACK :
+	    return ArenaPtr(new (arena.allocate<MsgPackWriter>(1)) MsgPackWriter(buffer, stackArena));
+
+	case JSON :
+	default :
+	    return ArenaPtr(new (arena.allocate<JsonWriter>(1)) JsonWriter(buffer, stackArena));
+    }
+}
+
+// =====================================================================================================================
+void ResponseWriter::value(const JsonValue& v)
+{
+    switch (v.type())
+    {
+	case Json::nullValue :
+	    null();
+	    break;
+
+	case Json::intValue :
+	    value(v.asInt64());
+	    break;
+
+	case Json::uintValue :
+	    value(v.asUInt64());
+	    break;
+
+	case Json::realValue :
+	    value(v.asDouble());
+	    break;
+
+	case Json::stringValue :
+	    writeString(v.stringData(), v.stringSize());
+	    break;
+
+	case Json::booleanValue :
+	    value(v.asBool());
+	    break;
+
+	case Json::arrayValue :
+	    beginArray();
+	    for (JsonValue::ArrayIndex i = 0; i < v.size(); ++i)
+		value(v[i]);
+	    endArray();
+	    break;
+
+	case Json::objectValue :
+	    beginObject();
+	    for (JsonValue::ArrayIndex i = 0; i < v.size(); ++i)
+	    {
+		const JsonValue::Member& m = v.member(i);
+		key(m.m_key, m.m_keySize);
+		value(m.m_value);
+	    }
+	    endObject();
+	    break;
+    }
+}
+
+// =====================================================================================================================
+ResponseWriter::Mark ResponseWriter::mark() const
+{
+    Mark m;
+    m.m_size = m_buffer.size();
+    m.m_depth = m_stack.size();
+    m.m_count = m_count;
+    m.m_afterKey = m_afterKey;
+    return m;
+}
+
+// =====================================================================================================================
+void ResponseWriter::rollback(const Mark& m)
+{
+    m_buffer.resize(m.m_size);
+    m_stack.resize(m.m_depth);
+    m_count = m.m_count;
+    m_afterKey = m.m_afterKey;
+}
+
+// =====================================================================================================================
+bool ResponseWriter::nextItem()
+{
+    if (m_afterKey)
+    {
+	m_afterKey = false;
+	return false;
+    }
+
+    ++m_count;
+
+    return true;
+}
+
+// =====================================================================================================================
+void ResponseWriter::push(size_t position)
+{
+    Container c;
+    c.m_position = position;
+    c.m_count = m_count;
+    m_stack.push_back(c);
+
+    m_count = 0;
+}
+
+// =====================================================================================================================
+size_t ResponseWriter::pop(size_t& count)
+{
+    const Container& c = m_stack.back();
+    size_t position = c.m_position;
+
+    count = m_count;
+    m_count = c.m_count;
+
+    m_stack.pop_back();
+
+    return position;
+}
@@ -0,0 +1,160 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_RESPONSEWRITER_H_INCLUDED
+#define JSONRPCREMOTE_RESPONSEWRITER_H_INCLUDED
+
+#include "jsonvalue.h"
+#include "arena.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Serializes values directly into a string buffer without building a document tree first. The method handlers write
+ * their results through this interface, the wire format is decided by the implementation.
+ */
+class ResponseWriter
+{
+    public:
+	enum Format
+	{
+	    JSON,
+	    MSGPACK,
+	    FORMAT_COUNT
+	};
+
+	/**
+	 * A position in the output that the writer can be rolled back to.
+	 */
+	struct Mark
+	{
+	    size_t m_size;
+	    size_t m_depth;
+	    size_t m_count;
+	    bool m_afterKey;
+	};
+
+	virtual ~ResponseWriter()
+	{}
+
+	typedef std::unique_ptr<ResponseWriter, ArenaDeleter<ResponseWriter>> ArenaPtr;
+
+	static std::unique_ptr<ResponseWriter> create(Format format, std::string& buffer);
+	// creates the writer in the given arena, the containers it keeps track of are stored in the arena as well if
+	// stackInArena is true; it has to be false if the writer is used by another thread than the owner of the arena
+	static ArenaPtr create(Format format, std::string& buffer, Arena& arena, bool stackInArena);
+
+	// creates a writer of the same format writing into another buffer, the output can be added with raw() later
+	std::unique_ptr<ResponseWriter> clone(std::string& buffer) const
+	{ return create(m_format, buffer); }
+
+	Format getFormat() const
+	{ return m_format; }
+
+	virtual void beginObject() = 0;
+	virtual void endObject() = 0;
+
+	virtual void beginArray() = 0;
+	virtual void endArray() = 0;
+
+	// writes the key of the next member of the current object
+	void key(const char* name)
+	{ writeKey(name, strlen(name)); }
+	void key(const std::string& name)
+	{ writeKey(name.data(), name.size()); }
+	void key(const char* name, size_t size)
+	{ writeKey(name, size); }
+
+	void null()
+	{ writeNull(); }
+	void value(bool v)
+	{ writeBool(v); }
+	void value(int v)
+	{ writeInt(v); }
+	void value(unsigned v)
+	{ writeUInt(v); }
+	void value(long v)
+	{ writeInt(v); }
+	void value(unsigned long v)
+	{ writeUInt(v); }
+	void value(long long v)
+	{ writeInt(v); }
+	void value(unsigned long long v)
+	{ writeUInt(v); }
+	void value(double v)
+	{ writeDouble(v); }
+	void value(const char* v)
+	{ writeString(v, strlen(v)); }
+	void value(const std::string& v)
+	{ writeString(v.data(), v.size()); }
+	void value(const JsonValue& v);
+
+	// writes binary data, formats without a binary type encode it as a string
+	void binary(const unsigned char* data, size_t size)
+	{ writeBinary(data, size); }
+
+	// writes a value already serialized by a writer of the same format
+	void raw(const std::string& data)
+	{ writeRaw(data); }
+
+	template<typename T>
+	void member(const char* name, const T& v)
+	{
+	    key(name);
+	    value(v);
+	}
+
+	Mark mark() const;
+	void rollback(const Mark& m);
+
+	const std::string& buffer() const
+	{ return m_buffer; }
+
+    protected:
+	ResponseWriter(Format format, std::string& buffer, Arena* arena);
+
+	virtual void writeKey(const char* name, size_t size) = 0;
+	virtual void writeNull() = 0;
+	virtual void writeBool(bool v) = 0;
+	virtual void writeInt(long long v) = 0;
+	virtual void writeUInt(unsigned long long v) = 0;
+	virtual void writeDouble(double v) = 0;
+	virtual void writeString(const char* s, size_t size) = 0;
+	virtual void writeBinary(const unsigned char* data, size_t size) = 0;
+	virtual void writeRaw(const std::string& data) = 0;
+
+	// called before every key and value, returns false for the value of a member because it belongs to its key
+	bool nextItem();
+
+	// keeps track of the containers, the position of the container in the output is stored for the implementations
+	void push(size_t position);
+	// returns the position of the closed container, the number of its items are returned in count
+	size_t pop(size_t& count);
+
+    protected:
+	std::string& m_buffer;
+
+	// number of items written into the current container, members are counted once with their key
+	size_t m_count;
+	// true if a key was written and its value is coming next
+	bool m_afterKey;
+
+    private:
+	struct Container
+	{
+	    size_t m_position;
+	    size_t m_count;
+	};
+
+	Format m_format;
+
+	std::vector<Container, ArenaAllocator<Container>> m_stack;
+};
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "scanwatcher.h"
+
+#include <algorithm>
+#include <chrono>
+
+// milliseconds the scanner is given for starting a requested scan, the scan is considered finished after it even if it
+// was never seen running
+static const int SCAN_START_TIMEOUT = 5 * 1000;
+
+// =====================================================================================================================
+ScanWatcher::ScanWatcher(const std::shared_ptr<zeppelin::library::MusicLibrary>& library,
+			 const std::function<void()>& changed)
+    : m_library(library),
+      m_changed(changed),
+      m_interval(0),
+      m_watching(false),
+      m_running(false),
+      m_requested(0)
+{
+}
+
+// =====================================================================================================================
+ScanWatcher::~ScanWatcher()
+{
+    stop();
+}
+
+// =====================================================================================================================
+void ScanWatcher::start(int interval)
+{
+    sample();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_watching)
+	return;
+
+    m_interval = std::max(interval, 1);
+    m_watching = true;
+
+    m_thread = std::thread(&ScanWatcher::run, this);
+}
+
+// =====================================================================================================================
+void ScanWatcher::stop()
+{
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (!m_watching)
+	    return;
+
+	m_watching = false;
+    }
+
+    m_cond.notify_all();
+
+    m_thread.join();
+}
+
+// =====================================================================================================================
+void ScanWatcher::scan()
+{
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	// the scanner gets to the request later, until then the scan is considered running already
+	if (m_watching)
+	    m_requested = SCAN_START_TIMEOUT / m_interval + 1;
+
+	setRunning(true);
+    }
+
+    m_library->scan();
+}
+
+// =====================================================================================================================
+bool ScanWatcher::isRunning()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (!m_watching)
+    {
+	lock.unlock();
+	sample();
+	lock.lock();
+    }
+
+    return m_running;
+}
+
+// =====================================================================================================================
+void ScanWatcher::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (m_watching)
+    {
+	m_cond.wait_for(lock, std::chrono::milliseconds(m_interval));
+
+	if (!m_watching)
+	    break;
+
+	lock.unlock();
+	sample();
+	lock.lock();
+    }
+}
+
+// =====================================================================================================================
+void ScanWatcher::sample()
+{
+    // the library is queried without holding the lock, the calls asking for the state are not blocked by it
+    auto status = m_library->getStatus();
+    bool scanning = status.m_scannerRunning || status.m_metaParserRunning;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // a requested scan is waited for until the scanner is seen running or the time given for starting it is over
+    if (scanning)
+	m_requested = 0;
+    else if (m_requested > 0)
+	--m_requested;
+
+    setRunning(scanning || m_requested > 0);
+}
+
+// =====================================================================================================================
+void ScanWatcher::setRunning(bool running)
+{
+    if (running == m_running)
+	return;
+
+    m_running = running;
+    m_changed();
+}
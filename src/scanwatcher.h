@@ -0,0 +1,64 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_SCANWATCHER_H_INCLUDED
+#define JSONRPCREMOTE_SCANWATCHER_H_INCLUDED
+
+#include <zeppelin/library/musiclibrary.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Samples the status of the library periodically and calls the given function every time a scan is started or
+ * finished. A scan requested through scan() is considered running from the request until the scanner is seen
+ * finishing it, the scanner may start it only later or finish it between two samples.
+ */
+class ScanWatcher
+{
+    public:
+	ScanWatcher(const std::shared_ptr<zeppelin::library::MusicLibrary>& library,
+		    const std::function<void()>& changed);
+	~ScanWatcher();
+
+	void start(int interval);
+	void stop();
+
+	// starts a scan of the library
+	void scan();
+
+	/**
+	 * Returns true if the contents of the library are being changed by a scan. The library is sampled by the caller
+	 * if the watcher is not running.
+	 */
+	bool isRunning();
+
+    private:
+	void run();
+
+	// takes a new sample of the library status and calls m_changed if the state of the scan changed
+	void sample();
+	void setRunning(bool running);
+
+    private:
+	std::shared_ptr<zeppelin::library::MusicLibrary> m_library;
+	std::function<void()> m_changed;
+
+	int m_interval;
+	bool m_watching;
+	std::thread m_thread;
+
+	bool m_running;
+	// number of samples a requested scan is still waited for, it is 0 if no scan was requested
+	int m_requested;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+};
+
+#endif
@@ -5,88 +5,136 @@
  */
 
 #include "server.h"
+#include "gzip.h"
+#include "jsonreader.h"
+#include "jsonwriter.h"
+#include "msgpackreader.h"
 
 #include <zeppelin/logger.h>
 #include <zeppelin/plugin/pluginmanager.h>
 #include <zeppelin/library/storage.h>
 
-#include <jsoncpp/json/reader.h>
-#include <jsoncpp/json/writer.h>
-
 #include <boost/lexical_cast.hpp>
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
-#include <boost/archive/iterators/ostream_iterator.hpp>
-
-#include <sstream>
 
-#define REGISTER_RPC_METHOD(name, function) \
-    m_rpcMethods[name] = std::bind(&Server::function, this, std::placeholders::_1, std::placeholders::_2)
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
 
-using namespace boost::archive::iterators;
+// number of workers executing the read-only calls of batch requests in parallel
+static const int DEFAULT_WORKERS = 4;
 
-typedef base64_from_binary<transform_width<const char*, 6, 8>> Base64;
-
-// =====================================================================================================================
-Server::Server(const std::shared_ptr<zeppelin::library::MusicLibrary>& library,
-	       const std::shared_ptr<zeppelin::player::Controller>& ctrl)
-    : m_library(library),
-      m_ctrl(ctrl)
-{
-    // library
-    REGISTER_RPC_METHOD("library_scan", libraryScan);
-    REGISTER_RPC_METHOD("library_get_status", libraryGetStatus);
-    REGISTER_RPC_METHOD("library_get_statistics", libraryGetStatistics);
+// number of objects loaded from the storage at once by the methods returning large listings, the result is serialized
+// slice by slice to keep only a bounded number of library objects in memory
+static const size_t FILE_SLICE_SIZE = 1000;
+static const size_t PICTURE_SLICE_SIZE = 16;
 
-    // library - artists
-    REGISTER_RPC_METHOD("library_get_artists", libraryGetArtists);
+// initial capacity of response buffers, most replies fit into it without growing the buffer several times
+static const size_t INITIAL_RESPONSE_SIZE = 4096;
 
-    // library - albums
-    REGISTER_RPC_METHOD("library_get_album_ids_by_artist", libraryGetAlbumIdsByArtist);
-    REGISTER_RPC_METHOD("library_get_albums", libraryGetAlbums);
-    REGISTER_RPC_METHOD("library_get_pictures_of_albums", libraryGetPicturesOfAlbums);
+// number of objects returned by the listing methods at once if the client did not specify it, and the upper limit
+static const size_t DEFAULT_LIST_LIMIT = 100;
+static const size_t MAX_LIST_LIMIT = 1000;
 
-    // library - files
-    REGISTER_RPC_METHOD("library_get_files", libraryGetFiles);
-    REGISTER_RPC_METHOD("library_get_file_ids_of_album", libraryGetFileIdsOfAlbum);
+// maximum number of bytes used for caching the encoded pictures of albums
+static const size_t DEFAULT_PICTURE_CACHE_SIZE = 32 * 1024 * 1024;
 
-    // library - directories
-    REGISTER_RPC_METHOD("library_get_directories", libraryGetDirectories);
+// number of finished background jobs whose state is remembered for job_status
+static const size_t JOB_HISTORY_SIZE = 100;
 
-    // library - metadata
-    REGISTER_RPC_METHOD("library_update_metadata", libraryUpdateMetadata);
+// number of changes of library objects remembered for library_get_changes
+static const size_t CHANGE_LOG_SIZE = 500 * 1000;
 
-    // libray - playlists
-    REGISTER_RPC_METHOD("library_create_playlist", libraryCreatePlaylist);
-    REGISTER_RPC_METHOD("library_delete_playlist", libraryDeletePlaylist);
-    REGISTER_RPC_METHOD("library_add_playlist_item", libraryAddPlaylistItem);
-    REGISTER_RPC_METHOD("library_delete_playlist_item", libraryDeletePlaylistItem);
-    REGISTER_RPC_METHOD("library_get_playlists", libraryGetPlaylists);
+// responses smaller than this are sent uncompressed even if the client asked for compression
+static const size_t DEFAULT_COMPRESSION_MIN_SIZE = 1024;
+static const int DEFAULT_COMPRESSION_LEVEL = 6;
 
-    // player queue
-    REGISTER_RPC_METHOD("player_queue_file", playerQueueFile);
-    REGISTER_RPC_METHOD("player_queue_directory", playerQueueDirectory);
-    REGISTER_RPC_METHOD("player_queue_album", playerQueueAlbum);
-    REGISTER_RPC_METHOD("player_queue_playlist", playerQueuePlaylist);
-    REGISTER_RPC_METHOD("player_queue_get", playerQueueGet);
-    REGISTER_RPC_METHOD("player_queue_remove", playerQueueRemove);
-    REGISTER_RPC_METHOD("player_queue_remove_all", playerQueueRemoveAll);
+// milliseconds between two checks of the player status for long polling clients
+static const int DEFAULT_STATUS_INTERVAL = 100;
+// milliseconds between two checks of the library status for noticing the start and the end of scans
+static const int DEFAULT_SCAN_INTERVAL = 100;
+// milliseconds player_wait_status blocks at most for a status change
+static const int DEFAULT_WAIT_STATUS_TIMEOUT = 30 * 1000;
+static const int MAX_WAIT_STATUS_TIMEOUT = 60 * 1000;
 
-    // player status
-    REGISTER_RPC_METHOD("player_status", playerStatus);
+#define RPC_METHOD(name, function, flags) \
+    { name, &Server::function, flags }
 
-    // player control
-    REGISTER_RPC_METHOD("player_play", playerPlay);
-    REGISTER_RPC_METHOD("player_pause", playerPause);
-    REGISTER_RPC_METHOD("player_stop", playerStop);
-    REGISTER_RPC_METHOD("player_seek", playerSeek);
-    REGISTER_RPC_METHOD("player_prev", playerPrev);
-    REGISTER_RPC_METHOD("player_next", playerNext);
-    REGISTER_RPC_METHOD("player_goto", playerGoto);
+// the methods are looked up with binary search, the table must be kept sorted by name (checked at compile time)
+constexpr Server::RpcMethod Server::s_rpcMethods[] =
+{
+    RPC_METHOD("job_cancel", jobCancel, RPC_WRITE),
+    RPC_METHOD("job_status", jobStatus, RPC_READ),
+    RPC_METHOD("library_add_playlist_item", libraryAddPlaylistItem, RPC_WRITE),
+    RPC_METHOD("library_create_playlist", libraryCreatePlaylist, RPC_WRITE),
+    RPC_METHOD("library_delete_playlist", libraryDeletePlaylist, RPC_WRITE),
+    RPC_METHOD("library_delete_playlist_item", libraryDeletePlaylistItem, RPC_WRITE),
+    RPC_METHOD("library_get_album_ids_by_artist", libraryGetAlbumIdsByArtist, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_albums", libraryGetAlbums, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_artists", libraryGetArtists, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_changes", libraryGetChanges, RPC_READ),
+    RPC_METHOD("library_get_directories", libraryGetDirectories, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_file_ids_of_album", libraryGetFileIdsOfAlbum, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_files", libraryGetFiles, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_pictures_of_albums", libraryGetPicturesOfAlbums, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_playlists", libraryGetPlaylists, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_statistics", libraryGetStatistics, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_get_status", libraryGetStatus, RPC_READ),
+    RPC_METHOD("library_list_albums", libraryListAlbums, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_list_artists", libraryListArtists, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_list_files", libraryListFiles, RPC_READ | RPC_LIBRARY),
+    RPC_METHOD("library_scan", libraryScan, RPC_WRITE),
+    RPC_METHOD("library_update_metadata", libraryUpdateMetadata, RPC_WRITE),
+    RPC_METHOD("player_get_volume", playerGetVolume, RPC_READ),
+    RPC_METHOD("player_goto", playerGoto, RPC_WRITE),
+    RPC_METHOD("player_next", playerNext, RPC_WRITE),
+    RPC_METHOD("player_pause", playerPause, RPC_WRITE),
+    RPC_METHOD("player_play", playerPlay, RPC_WRITE),
+    RPC_METHOD("player_prev", playerPrev, RPC_WRITE),
+    RPC_METHOD("player_queue_album", playerQueueAlbum, RPC_WRITE),
+    RPC_METHOD("player_queue_albums", playerQueueAlbums, RPC_WRITE),
+    RPC_METHOD("player_queue_directory", playerQueueDirectory, RPC_WRITE),
+    RPC_METHOD("player_queue_file", playerQueueFile, RPC_WRITE),
+    RPC_METHOD("player_queue_get", playerQueueGet, RPC_READ),
+    RPC_METHOD("player_queue_playlist", playerQueuePlaylist, RPC_WRITE),
+    RPC_METHOD("player_queue_remove", playerQueueRemove, RPC_WRITE),
+    RPC_METHOD("player_queue_remove_all", playerQueueRemoveAll, RPC_WRITE),
+    RPC_METHOD("player_seek", playerSeek, RPC_WRITE),
+    RPC_METHOD("player_set_volume", playerSetVolume, RPC_WRITE),
+    RPC_METHOD("player_status", playerStatus, RPC_READ),
+    RPC_METHOD("player_stop", playerStop, RPC_WRITE),
+    // not flagged as read-only to keep it away from the worker pool, it may block for a long time
+    RPC_METHOD("player_wait_status", playerWaitStatus, RPC_WRITE),
+    RPC_METHOD("server_get_metrics", serverGetMetrics, RPC_READ)
+};
 
-    // player volume
-    REGISTER_RPC_METHOD("player_get_volume", playerGetVolume);
-    REGISTER_RPC_METHOD("player_set_volume", playerSetVolume);
+// =====================================================================================================================
+Server::Server(const std::shared_ptr<zeppelin::library::MusicLibrary>& library,
+	       const std::shared_ptr<zeppelin::player::Controller>& ctrl)
+    : m_library(library),
+      m_ctrl(ctrl),
+      m_statusWatcher(ctrl),
+      // nothing seen before the start of a scan or meanwhile may be considered valid after its end, the generations
+      // are bumped when a scan starts and when it is finished
+      m_scanWatcher(library,
+		    [this]()
+		    {
+			++m_scanGeneration;
+			++m_libraryGeneration;
+		    }),
+      m_pictureCaches{{DEFAULT_PICTURE_CACHE_SIZE}, {DEFAULT_PICTURE_CACHE_SIZE}},
+      // the generations of the change log start from the current time for the same reason as the library generation
+      m_changeLog(CHANGE_LOG_SIZE, std::time(nullptr)),
+      m_metrics(getRpcMethodNames()),
+      m_jobs(JOB_HISTORY_SIZE),
+      m_compressionMinSize(DEFAULT_COMPRESSION_MIN_SIZE),
+      m_compressionLevel(DEFAULT_COMPRESSION_LEVEL),
+      // start from the current time to make sure etags handed out before a restart of the plugin are not accepted
+      m_libraryGeneration(std::time(nullptr)),
+      m_scanGeneration(1)
+{
 }
 
 // =====================================================================================================================
@@ -98,6 +146,44 @@ void Server::start(const Json::Value& config, zeppelin::plugin::PluginManager& p
 	return;
     }
 
+    int workers = DEFAULT_WORKERS;
+
+    if (config.isMember("workers") && config["workers"].isInt())
+	workers = config["workers"].asInt();
+
+    m_workers.start(workers);
+    m_jobs.start();
+
+    int statusInterval = DEFAULT_STATUS_INTERVAL;
+
+    if (config.isMember("status_interval") && config["status_interval"].isInt())
+	statusInterval = config["status_interval"].asInt();
+
+    m_statusWatcher.start(statusInterval);
+
+    int scanInterval = DEFAULT_SCAN_INTERVAL;
+
+    if (config.isMember("scan_interval") && config["scan_interval"].isInt())
+	scanInterval = config["scan_interval"].asInt();
+
+    m_scanWatcher.start(scanInterval);
+
+    if (config.isMember("picture_cache_size") && config["picture_cache_size"].isUInt())
+    {
+	for (PictureCache& cache : m_pictureCaches)
+	    cache.setCapacity(config["picture_cache_size"].asUInt());
+    }
+
+    if (config.isMember("compression") && config["compression"].isObject())
+    {
+	const Json::Value& compression = config["compression"];
+
+	if (compression.isMember("min_size") && compression["min_size"].isUInt())
+	    m_compressionMinSize = compression["min_size"].asUInt();
+	if (compression.isMember("level") && compression["level"].isInt())
+	    m_compressionLevel = compression["level"].asInt();
+    }
+
     try
     {
 	httpserver::HttpServer& httpServer = static_cast<httpserver::HttpServer&>(pm.getInterface("http-server"));
@@ -110,6 +196,14 @@ void Server::start(const Json::Value& config, zeppelin::plugin::PluginManager& p
 
 	httpServer.registerHandler(config["path"].asString(),
 	    std::bind(&Server::processRequest, this, std::placeholders::_1));
+	httpServer.registerHandler(config["path"].asString() + "/gzip",
+	    std::bind(&Server::processCompressedRequest, this, std::placeholders::_1));
+	httpServer.registerHandler(config["path"].asString() + "/msgpack",
+	    std::bind(&Server::processMsgPackRequest, this, std::placeholders::_1));
+	httpServer.registerHandler(config["path"].asString() + "/picture",
+	    std::bind(&Server::processPictureRequest, this, std::placeholders::_1));
+	httpServer.registerHandler(config["path"].asString() + "/metrics",
+	    std::bind(&Server::processMetricsRequest, this, std::placeholders::_1));
     }
     catch (const zeppelin::plugin::PluginInterfaceNotFoundException&)
     {
@@ -120,145 +214,732 @@ void Server::start(const Json::Value& config, zeppelin::plugin::PluginManager& p
 // =====================================================================================================================
 void Server::stop()
 {
+    m_statusWatcher.stop();
+    m_scanWatcher.stop();
+    m_jobs.stop();
+    m_workers.stop();
 }
 
 // =====================================================================================================================
-static inline std::unique_ptr<httpserver::HttpResponse> createJsonErrorReply(const httpserver::HttpRequest& httpReq,
-									     const Json::Value& request,
-									     const std::string& reason)
+static inline void writeError(ResponseWriter& response, const JsonValue& request, const std::string& reason)
 {
-    Json::Value response(Json::objectValue);
-    response["jsonrpc"] = "2.0";
-    response["error"] = reason;
+    response.beginObject();
+    response.member("jsonrpc", "2.0");
+    response.member("error", reason);
 
-    if (request.isMember("id"))
-	response["id"] = request["id"];
+    response.key("id");
+    if (request.isObject() && request.isMember("id"))
+	response.value(request["id"]);
     else
-	response["id"] = Json::Value(Json::nullValue);
+	response.null();
 
-    return httpReq.createBufferedResponse(200,
-					  Json::FastWriter().write(response));
+    response.endObject();
 }
 
 // =====================================================================================================================
 std::unique_ptr<httpserver::HttpResponse> Server::processRequest(const httpserver::HttpRequest& request)
 {
-    Json::Value root;
-    Json::Reader reader;
+    // everything allocated while the request is processed is released at once when the arena goes out of scope
+    Arena arena;
+
+    return createReply(request,
+		       processBody(request.getData(), arena, ResponseWriter::JSON),
+		       ResponseWriter::JSON,
+		       false);
+}
+
+// =====================================================================================================================
+std::unique_ptr<httpserver::HttpResponse> Server::processCompressedRequest(const httpserver::HttpRequest& request)
+{
+    Arena arena;
+
+    return createReply(request,
+		       processBody(request.getData(), arena, ResponseWriter::JSON),
+		       ResponseWriter::JSON,
+		       true);
+}
+
+// =====================================================================================================================
+std::unique_ptr<httpserver::HttpResponse> Server::processMsgPackRequest(const httpserver::HttpRequest& request)
+{
+    Arena arena;
+
+    return createReply(request,
+		       processBody(request.getData(), arena, ResponseWriter::MSGPACK),
+		       ResponseWriter::MSGPACK,
+		       false);
+}
+
+// =====================================================================================================================
+std::unique_ptr<httpserver::HttpResponse> Server::createReply(const httpserver::HttpRequest& httpReq,
+							      const std::string& body,
+							      ResponseWriter::Format format,
+							      bool compress)
+{
+    std::string compressed;
+
+    // small responses are not worth compressing, the gzip header and the time spent would be wasted
+    compress = compress && body.size() >= m_compressionMinSize && Gzip::compress(body, compressed, m_compressionLevel);
+
+    std::unique_ptr<httpserver::HttpResponse> resp = httpReq.createBufferedResponse(200, compress ? compressed : body);
+    if (format == ResponseWriter::MSGPACK)
+	resp->addHeader("Content-Type", "application/msgpack");
+    else
+	resp->addHeader("Content-Type", "application/json;charset=utf-8");
+
+    if (compress)
+	resp->addHeader("Content-Encoding", "gzip");
+
+    return resp;
+}
+
+// =====================================================================================================================
+std::string Server::processBody(const std::string& data, Arena& arena, ResponseWriter::Format format)
+{
+    // the parsed request refers to the original buffer, only escaped strings and the value tree live in the arena
+    JsonValue root;
+    bool valid;
+
+    if (format == ResponseWriter::MSGPACK)
+	valid = MsgPackReader(arena).parse(data, root);
+    else
+	valid = JsonReader(arena).parse(data, root);
+
+    std::string body;
+    body.reserve(INITIAL_RESPONSE_SIZE);
+
+    // the writer and the stack of its open containers live in the arena
+    ResponseWriter::ArenaPtr writer = ResponseWriter::create(format, body, arena, true);
+    ResponseWriter& response = *writer;
+
+    if (!valid)
+    {
+	writeError(response, JsonValue(), "invalid request");
+	m_metrics.recordRequest(format, data.size(), body.size());
+	return body;
+    }
+
+    if (root.isArray())
+    {
+	// batch request, the calls are answered in the order they were received
+	if (root.empty())
+	    writeError(response, JsonValue(), "invalid request");
+	else
+	{
+	    response.beginArray();
+	    processBatch(root, response, arena);
+	    response.endArray();
+	}
+    }
+    else
+	processCall(root, response);
+
+    m_metrics.recordRequest(format, data.size(), body.size());
+
+    return body;
+}
+
+// =====================================================================================================================
+static inline const char* pictureTypeName(zeppelin::library::Picture::Type type)
+{
+    switch (type)
+    {
+	case zeppelin::library::Picture::FrontCover :
+	    return "frontcover";
+	case zeppelin::library::Picture::BackCover :
+	    return "backcover";
+    }
+
+    return "";
+}
+
+// =====================================================================================================================
+std::unique_ptr<httpserver::HttpResponse> Server::processPictureRequest(const httpserver::HttpRequest& request)
+{
+    Arena arena;
+    JsonReader reader(arena);
+    JsonValue root;
+
+    if (!reader.parse(request.getData(), root) ||
+	!root.isObject() ||
+	!root.isMember("album_id") || !root["album_id"].isInt() ||
+	!root.isMember("type") || !root["type"].isString())
+	return request.createBufferedResponse(400, "");
+
+    auto result = m_library->getStorage().getPicturesOfAlbums({root["album_id"].asInt()});
+
+    for (const auto& it : result)
+    {
+	for (const auto& pit : it.second)
+	{
+	    const char* type = pictureTypeName(pit.first);
+
+	    if (!root["type"].equals(type, strlen(type)))
+		continue;
+
+	    // the picture is sent as is, without any encoding
+	    const auto& data = pit.second->getData();
+
+	    std::unique_ptr<httpserver::HttpResponse> resp = request.createBufferedResponse(200,
+		std::string(reinterpret_cast<const char*>(&data[0]), data.size()));
+	    resp->addHeader("Content-Type", pit.second->getMimeType());
+	    return resp;
+	}
+    }
+
+    return request.createBufferedResponse(404, "");
+}
+
+// =====================================================================================================================
+std::unique_ptr<httpserver::HttpResponse> Server::processMetricsRequest(const httpserver::HttpRequest& request)
+{
+    std::string body;
+    body.reserve(INITIAL_RESPONSE_SIZE);
+
+    m_metrics.writePrometheus(body);
+
+    std::unique_ptr<httpserver::HttpResponse> resp = request.createBufferedResponse(200, body);
+    resp->addHeader("Content-Type", "text/plain; version=0.0.4");
+    return resp;
+}
+
+// =====================================================================================================================
+void Server::processBatch(const JsonValue& calls, ResponseWriter& response, Arena& arena)
+{
+    JsonValue::ArrayIndex i = 0;
+
+    while (i < calls.size())
+    {
+	// collect the following run of read-only calls, they can be executed at the same time
+	JsonValue::ArrayIndex end = i;
+
+	while (end < calls.size() && isReadOnlyCall(calls[end]))
+	    ++end;
+
+	if (end - i > 1 && m_workers.isRunning())
+	{
+	    // parallel calls are serialized into their own buffers and copied into the response in order
+	    ResponseWriter::Format format = response.getFormat();
+	    std::vector<std::string, ArenaAllocator<std::string>> results(end - i, std::string(), arena);
+	    std::vector<ResponseWriter::ArenaPtr, ArenaAllocator<ResponseWriter::ArenaPtr>> writers(arena);
+	    std::vector<std::future<void>, ArenaAllocator<std::future<void>>> futures(arena);
+	    writers.reserve(end - i);
+	    futures.reserve(end - i);
+
+	    try
+	    {
+		for (JsonValue::ArrayIndex j = i; j < end; ++j)
+		{
+		    const JsonValue& call = calls[j];
+		    std::string& result = results[j - i];
+
+		    // the arena is not shared with the workers, the writers are created here and their stacks are kept
+		    // on the heap
+		    writers.push_back(ResponseWriter::create(format, result, arena, false));
+		    ResponseWriter* writer = writers.back().get();
+
+		    futures.push_back(m_workers.submit(
+			[this, &call, &result, writer]()
+			{
+			    result.reserve(INITIAL_RESPONSE_SIZE);
+			    processCall(call, *writer);
+			}));
+		}
+	    }
+	    catch (...)
+	    {
+		// the submitted calls write into the results and the writers, they must not be released under them
+		for (auto& f : futures)
+		    f.wait();
+
+		throw;
+	    }
+
+	    // every call has to finish before the error of one of them may unwind and release the results
+	    for (auto& f : futures)
+		f.wait();
+
+	    for (JsonValue::ArrayIndex j = 0; j < futures.size(); ++j)
+	    {
+		futures[j].get();
+		response.raw(results[j]);
+	    }
+	}
+	else
+	{
+	    for (JsonValue::ArrayIndex j = i; j < end; ++j)
+		processCall(calls[j], response);
+	}
+
+	// calls changing the state are executed in order after the previous calls have finished
+	if (end < calls.size())
+	{
+	    processCall(calls[end], response);
+	    ++end;
+	}
+
+	i = end;
+    }
+}
+
+// =====================================================================================================================
+bool Server::isReadOnlyCall(const JsonValue& call) const
+{
+    if (!call.isObject() || !call.isMember("method") || !call["method"].isString())
+	return false;
+
+    const JsonValue& name = call["method"];
+    const RpcMethod* method = findRpcMethod(name.stringData(), name.stringSize());
+
+    return method && (method->m_flags & RPC_READ);
+}
+
+// =====================================================================================================================
+static constexpr bool isLess(const char* s1, const char* s2)
+{
+    return *s1 == *s2 ?
+	(*s1 != '\0' && isLess(s1 + 1, s2 + 1)) :
+	static_cast<unsigned char>(*s1) < static_cast<unsigned char>(*s2);
+}
+
+// =====================================================================================================================
+constexpr bool Server::isSorted(const RpcMethod* methods, size_t count)
+{
+    return count < 2 || (isLess(methods[0].m_name, methods[1].m_name) && isSorted(methods + 1, count - 1));
+}
+
+// =====================================================================================================================
+// compares a NUL terminated string with a string given by its size, the same ordering as strcmp()
+static inline int compareName(const char* s1, const char* s2, size_t size)
+{
+    int r = strncmp(s1, s2, size);
+
+    if (r != 0)
+	return r;
+
+    return s1[size] == '\0' ? 0 : 1;
+}
+
+// =====================================================================================================================
+const Server::RpcMethod* Server::findRpcMethod(const char* name, size_t size)
+{
+    static const size_t count = sizeof(s_rpcMethods) / sizeof(s_rpcMethods[0]);
 
-    if (!reader.parse(request.getData(), root))
-	return createJsonErrorReply(request, root, "invalid request");
+    static_assert(isSorted(s_rpcMethods, count), "RPC method table is not sorted");
 
-    if (!root.isMember("method") || !root.isMember("id"))
-	return createJsonErrorReply(request, root, "method/id not found");
+    // method names are not terminated in the request buffer
+    const RpcMethod* end = s_rpcMethods + count;
+    const RpcMethod* it = std::lower_bound(
+	s_rpcMethods,
+	end,
+	name,
+	[size](const RpcMethod& m, const char* n)
+	{
+	    return compareName(m.m_name, n, size) < 0;
+	});
 
-    Json::Value params;
+    if (it == end || compareName(it->m_name, name, size) != 0)
+	return nullptr;
+
+    return it;
+}
 
-    if (root.isMember("params"))
-	params = root["params"];
+// =====================================================================================================================
+void Server::processCall(const JsonValue& call, ResponseWriter& response)
+{
+    if (!call.isObject())
+    {
+	writeError(response, call, "invalid request");
+	return;
+    }
 
-    Json::Value result;
-    std::string method = root["method"].asString();
+    if (!call.isMember("method") || !call.isMember("id"))
+    {
+	writeError(response, call, "method/id not found");
+	return;
+    }
 
-    auto it = m_rpcMethods.find(method);
+    static const JsonValue noParams;
+    const JsonValue& params = call.isMember("params") ? call["params"] : noParams;
 
-    if (it == m_rpcMethods.end())
-	return createJsonErrorReply(request, root, "invalid method");
+    const JsonValue& name = call["method"];
+    const RpcMethod* method = name.isString() ? findRpcMethod(name.stringData(), name.stringSize()) : nullptr;
+
+    if (!method)
+    {
+	m_metrics.recordInvalidCall();
+	writeError(response, call, "invalid method");
+	return;
+    }
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    size_t replyStart = response.buffer().size();
+
+    // the status of the library is sampled by every call to notice the end of scans started from anywhere
+    unsigned long long generation = getLibraryGeneration();
+
+    // the result of library methods is identified by the generation of the library, clients can skip downloading it
+    // again by sending the etag of their previous result
+    std::string etag;
+
+    if ((method->m_flags & RPC_LIBRARY) && generation != 0)
+	etag = std::to_string(generation);
+
+    if (!etag.empty() &&
+	call.isMember("if_none_match") &&
+	call["if_none_match"].isString() &&
+	call["if_none_match"].equals(etag))
+    {
+	response.beginObject();
+	response.member("jsonrpc", "2.0");
+	response.member("id", call["id"]);
+	response.member("etag", etag);
+
+	response.key("result");
+	response.beginObject();
+	response.member("not_modified", true);
+	response.endObject();
+
+	response.endObject();
+
+	recordCall(method, begin, response.buffer().size() - replyStart, false);
+	return;
+    }
+
+    // the result is serialized by the method right into the response, remember where the reply starts to be able to
+    // replace it with an error if the method fails half way
+    ResponseWriter::Mark start = response.mark();
+
+    response.beginObject();
+    response.member("jsonrpc", "2.0");
+    response.member("id", call["id"]);
+
+    if (!etag.empty())
+	response.member("etag", etag);
+
+    response.key("result");
+
+    size_t resultStart = response.buffer().size();
 
     try
     {
-	it->second(params, result);
+	(this->*method->m_function)(params, response);
     }
     catch (...)
     {
-	return createJsonErrorReply(request, root, "invalid method call");
+	response.rollback(start);
+	writeError(response, call, "invalid method call");
+
+	recordCall(method, begin, response.buffer().size() - replyStart, true);
+	return;
     }
 
-    Json::Value response(Json::objectValue);
-    response["jsonrpc"] = "2.0";
-    response["id"] = root["id"];
-    response["result"] = result;
+    // methods without a return value leave the result empty
+    if (response.buffer().size() == resultStart)
+	response.null();
 
-    std::unique_ptr<httpserver::HttpResponse> resp = request.createBufferedResponse(200,
-										    Json::FastWriter().write(response));
-    resp->addHeader("Content-Type", "application/json;charset=utf-8");
-    return resp;
+    response.endObject();
+
+    recordCall(method, begin, response.buffer().size() - replyStart, false);
 }
 
 // =====================================================================================================================
-void Server::libraryScan(const Json::Value& request, Json::Value& response)
+void Server::recordCall(const RpcMethod* method,
+			const std::chrono::steady_clock::time_point& begin,
+			size_t responseBytes,
+			bool error)
 {
-    m_library->scan();
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - begin;
+
+    m_metrics.recordCall(method - s_rpcMethods,
+			 std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+			 responseBytes,
+			 error);
 }
 
 // =====================================================================================================================
-void Server::libraryGetStatus(const Json::Value& request, Json::Value& response)
+std::vector<const char*> Server::getRpcMethodNames()
+{
+    std::vector<const char*> names;
+
+    for (const RpcMethod& method : s_rpcMethods)
+	names.push_back(method.m_name);
+
+    return names;
+}
+
+// =====================================================================================================================
+unsigned long long Server::getLibraryGeneration()
+{
+    if (m_scanWatcher.isRunning())
+	return 0;
+
+    return m_libraryGeneration;
+}
+
+// =====================================================================================================================
+unsigned long long Server::getScanGeneration()
+{
+    if (m_scanWatcher.isRunning())
+	return 0;
+
+    return m_scanGeneration;
+}
+
+// =====================================================================================================================
+void Server::libraryScan(const JsonValue& request, ResponseWriter& response)
+{
+    m_scanWatcher.scan();
+}
+
+// =====================================================================================================================
+void Server::libraryGetStatus(const JsonValue& request, ResponseWriter& response)
 {
     auto status = m_library->getStatus();
 
-    response = Json::Value(Json::objectValue);
-    response["scanner_running"] = status.m_scannerRunning;
-    response["metaparser_running"] = status.m_metaParserRunning;
+    response.beginObject();
+    response.member("scanner_running", status.m_scannerRunning);
+    response.member("metaparser_running", status.m_metaParserRunning);
+    response.endObject();
 }
 
 // =====================================================================================================================
-void Server::libraryGetStatistics(const Json::Value& request, Json::Value& response)
+void Server::libraryGetStatistics(const JsonValue& request, ResponseWriter& response)
 {
     auto stat = m_library->getStorage().getStatistics();
 
-    response = Json::Value(Json::objectValue);
-    response["num_of_artists"] = stat.m_numOfArtists;
-    response["num_of_albums"] = stat.m_numOfAlbums;
-    response["num_of_files"] = stat.m_numOfFiles;
-    response["sum_of_song_lengths"] = boost::lexical_cast<std::string>(stat.m_sumOfSongLengths);
-    response["sum_of_file_sizes"] = boost::lexical_cast<std::string>(stat.m_sumOfFileSizes);
+    response.beginObject();
+    response.member("num_of_artists", stat.m_numOfArtists);
+    response.member("num_of_albums", stat.m_numOfAlbums);
+    response.member("num_of_files", stat.m_numOfFiles);
+    response.member("sum_of_song_lengths", boost::lexical_cast<std::string>(stat.m_sumOfSongLengths));
+    response.member("sum_of_file_sizes", boost::lexical_cast<std::string>(stat.m_sumOfFileSizes));
+    response.endObject();
 }
 
 // =====================================================================================================================
-void Server::libraryGetArtists(const Json::Value& request, Json::Value& response)
+// a member of the serialized library objects, the accessor of the object is called only if the field is selected
+template<typename T>
+struct Field
 {
-    std::vector<int> ids;
+    const char* m_name;
+    void (*m_write)(const T& object, ResponseWriter& response);
+};
+
+static const Field<zeppelin::library::Artist> s_artistFields[] = {
+    { "id", [](const zeppelin::library::Artist& a, ResponseWriter& w) { w.value(a.m_id); } },
+    { "name", [](const zeppelin::library::Artist& a, ResponseWriter& w) { w.value(a.m_name); } },
+    { "albums", [](const zeppelin::library::Artist& a, ResponseWriter& w) { w.value(a.m_albums); } }
+};
+
+static const Field<zeppelin::library::Album> s_albumFields[] = {
+    { "id", [](const zeppelin::library::Album& a, ResponseWriter& w) { w.value(a.m_id); } },
+    { "name", [](const zeppelin::library::Album& a, ResponseWriter& w) { w.value(a.m_name); } },
+    { "artist_id", [](const zeppelin::library::Album& a, ResponseWriter& w) { w.value(a.m_artistId); } },
+    { "songs", [](const zeppelin::library::Album& a, ResponseWriter& w) { w.value(a.m_songs); } }
+};
+
+static const Field<zeppelin::library::Directory> s_directoryFields[] = {
+    { "id", [](const zeppelin::library::Directory& d, ResponseWriter& w) { w.value(d.m_id); } },
+    { "name", [](const zeppelin::library::Directory& d, ResponseWriter& w) { w.value(d.m_name); } },
+    { "parent_id", [](const zeppelin::library::Directory& d, ResponseWriter& w) { w.value(d.m_parentId); } }
+};
+
+static const Field<zeppelin::library::File> s_fileFields[] = {
+    { "id", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_id); } },
+    { "path", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_path); } },
+    { "name", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_name); } },
+    { "directory_id", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_directoryId); } },
+    { "artist_id", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_artistId); } },
+    { "album_id", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_albumId); } },
+    { "length", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_metadata->getLength()); } },
+    { "title", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_metadata->getTitle()); } },
+    { "year", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_metadata->getYear()); } },
+    { "track_index",
+      [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_metadata->getTrackIndex()); } },
+    { "codec", [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_metadata->getCodec()); } },
+    { "sample_rate",
+      [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_metadata->getSampleRate()); } },
+    { "sample_size",
+      [](const zeppelin::library::File& f, ResponseWriter& w) { w.value(f.m_metadata->getSampleSize()); } }
+};
 
-    requireType(request, "id", Json::arrayValue);
+// =====================================================================================================================
+template<typename T, size_t N>
+static constexpr unsigned allFields(const Field<T> (&)[N])
+{
+    static_assert(N <= sizeof(unsigned) * 8, "too many fields for the selection mask");
+
+    return (N == sizeof(unsigned) * 8) ? ~0u : (1u << N) - 1;
+}
+
+// =====================================================================================================================
+// returns the bit mask of the fields listed in the optional "fields" parameter, every field is selected without it
+template<typename T, size_t N>
+static unsigned selectFields(const JsonValue& request, const Field<T> (&fields)[N])
+{
+    if (!request.isMember("fields"))
+	return allFields(fields);
+
+    const JsonValue& names = request["fields"];
+
+    if (!names.isArray())
+	throw InvalidMethodCall();
 
-    for (Json::Value::ArrayIndex i = 0; i < request["id"].size(); ++i)
+    unsigned mask = 0;
+
+    for (JsonValue::ArrayIndex i = 0; i < names.size(); ++i)
     {
-	const Json::Value& v = request["id"][i];
+	const JsonValue& name = names[i];
 
-	if (!v.isInt())
+	if (!name.isString())
 	    throw InvalidMethodCall();
 
-	ids.push_back(v.asInt());
+	size_t j = 0;
+
+	while (j < N && !name.equals(fields[j].m_name, strlen(fields[j].m_name)))
+	    ++j;
+
+	if (j == N)
+	    throw InvalidMethodCall();
+
+	mask |= 1u << j;
+    }
+
+    return mask;
+}
+
+// =====================================================================================================================
+template<typename T, size_t N>
+static inline void writeFields(const T& object, const Field<T> (&fields)[N], unsigned mask, ResponseWriter& response)
+{
+    response.beginObject();
+
+    for (size_t i = 0; i < N; ++i)
+    {
+	if (mask & (1u << i))
+	{
+	    response.key(fields[i].m_name);
+	    fields[i].m_write(object, response);
+	}
     }
 
-    auto artists = m_library->getStorage().getArtists(ids);
+    response.endObject();
+}
+
+// =====================================================================================================================
+// returns true if the client asked for the columnar format, one array per field instead of an array of objects
+static bool isColumnFormat(const JsonValue& request)
+{
+    if (!request.isMember("format"))
+	return false;
+
+    const JsonValue& format = request["format"];
+
+    if (format.equals("columns", 7))
+	return true;
+
+    if (format.equals("objects", 7))
+	return false;
+
+    throw InvalidMethodCall();
+}
+
+// =====================================================================================================================
+// collects the selected fields of the added objects into one array per field, the columns are written when the last
+// object was added
+template<typename T>
+class ColumnWriter
+{
+    public:
+	// the columns are written in the format of the given writer, only the selected fields get a column
+	template<size_t N>
+	ColumnWriter(const Field<T> (&fields)[N], unsigned mask, const ResponseWriter& format)
+	{
+	    for (size_t i = 0; i < N; ++i)
+	    {
+		if (mask & (1u << i))
+		    m_fields.push_back(&fields[i]);
+	    }
+
+	    // the writers refer to the buffers, they are not reallocated after this point
+	    m_buffers.resize(m_fields.size());
+	    m_writers.reserve(m_fields.size());
+
+	    for (auto& buffer : m_buffers)
+	    {
+		m_writers.push_back(format.clone(buffer));
+		m_writers.back()->beginArray();
+	    }
+	}
+
+	void add(const T& object)
+	{
+	    for (size_t i = 0; i < m_fields.size(); ++i)
+		m_fields[i]->m_write(object, *m_writers[i]);
+	}
+
+	void write(ResponseWriter& response)
+	{
+	    response.beginObject();
+
+	    for (size_t i = 0; i < m_fields.size(); ++i)
+	    {
+		m_writers[i]->endArray();
+
+		response.key(m_fields[i]->m_name);
+		response.raw(m_buffers[i]);
+	    }
+
+	    response.endObject();
+	}
+
+    private:
+	std::vector<const Field<T>*> m_fields;
 
-    response = Json::Value(Json::arrayValue);
-    response.resize(artists.size());
+	std::vector<std::string> m_buffers;
+	std::vector<std::unique_ptr<ResponseWriter>> m_writers;
+};
 
-    for (Json::Value::ArrayIndex i = 0; i < artists.size(); ++i)
+// =====================================================================================================================
+template<typename Objects, typename T, size_t N>
+static void writeObjects(const Objects& objects,
+			 const Field<T> (&fields)[N],
+			 const JsonValue& request,
+			 ResponseWriter& response)
+{
+    unsigned mask = selectFields(request, fields);
+
+    if (isColumnFormat(request))
     {
-	const auto& a = artists[i];
+	ColumnWriter<T> columns(fields, mask, response);
 
-	Json::Value artist(Json::objectValue);
-	artist["id"] = a->m_id;
-	artist["name"] = a->m_name;
-	artist["albums"] = a->m_albums;
+	for (const auto& o : objects)
+	    columns.add(*o);
 
-	response[i].swap(artist);
+	columns.write(response);
+    }
+    else
+    {
+	response.beginArray();
+
+	for (const auto& o : objects)
+	    writeFields(*o, fields, mask, response);
+
+	response.endArray();
     }
 }
 
 // =====================================================================================================================
-void Server::libraryGetAlbums(const Json::Value& request, Json::Value& response)
+void Server::libraryGetArtists(const JsonValue& request, ResponseWriter& response)
 {
     std::vector<int> ids;
 
     requireType(request, "id", Json::arrayValue);
 
-    for (Json::Value::ArrayIndex i = 0; i < request["id"].size(); ++i)
+    for (JsonValue::ArrayIndex i = 0; i < request["id"].size(); ++i)
     {
-	const Json::Value& v = request["id"][i];
+	const JsonValue& v = request["id"][i];
 
 	if (!v.isInt())
 	    throw InvalidMethodCall();
@@ -266,35 +947,84 @@ void Server::libraryGetAlbums(const Json::Value& request, Json::Value& response)
 	ids.push_back(v.asInt());
     }
 
-    auto albums = m_library->getStorage().getAlbums(ids);
+    writeObjects(m_library->getStorage().getArtists(ids), s_artistFields, request, response);
+}
+
+// =====================================================================================================================
+void Server::libraryGetAlbums(const JsonValue& request, ResponseWriter& response)
+{
+    std::vector<int> ids;
+
+    requireType(request, "id", Json::arrayValue);
+
+    for (JsonValue::ArrayIndex i = 0; i < request["id"].size(); ++i)
+    {
+	const JsonValue& v = request["id"][i];
+
+	if (!v.isInt())
+	    throw InvalidMethodCall();
+
+	ids.push_back(v.asInt());
+    }
 
-    response = Json::Value(Json::arrayValue);
-    response.resize(albums.size());
+    writeObjects(m_library->getStorage().getAlbums(ids), s_albumFields, request, response);
+}
 
-    for (Json::Value::ArrayIndex i = 0; i < albums.size(); ++i)
+// =====================================================================================================================
+template<typename Pictures>
+static inline void encodePicturesOfAlbums(const Pictures& result,
+					  const ResponseWriter& format,
+					  std::map<int, std::shared_ptr<const PictureCache::Pictures>>& encoded)
+{
+    for (const auto& it : result)
     {
-	const auto& a = albums[i];
+	auto pictures = std::make_shared<PictureCache::Pictures>();
+
+	for (const auto& pit : it.second)
+	{
+	    std::string picture;
+	    std::unique_ptr<ResponseWriter> writer = format.clone(picture);
+
+	    writer->beginObject();
+	    writer->member("type", pictureTypeName(pit.first));
+	    writer->member("mimetype", pit.second->getMimeType());
+
+	    // the contents of the picture are encoded with base64 in JSON, binary formats send them as is
+	    const auto& data = pit.second->getData();
+	    writer->key("data");
+	    writer->binary(reinterpret_cast<const unsigned char*>(&data[0]), data.size());
 
-	Json::Value album(Json::objectValue);
-	album["id"] = a->m_id;
-	album["name"] = a->m_name;
-	album["artist_id"] = a->m_artistId;
-	album["songs"] = a->m_songs;
+	    writer->endObject();
 
-	response[i].swap(album);
+	    pictures->push_back(std::move(picture));
+	}
+
+	encoded[it.first] = pictures;
     }
 }
 
 // =====================================================================================================================
-void Server::libraryGetPicturesOfAlbums(const Json::Value& request, Json::Value& response)
+static inline void writePicturesOfAlbum(int albumId, const PictureCache::Pictures& pictures, ResponseWriter& response)
+{
+    response.key(std::to_string(albumId));
+    response.beginArray();
+
+    for (const auto& p : pictures)
+	response.raw(p);
+
+    response.endArray();
+}
+
+// =====================================================================================================================
+void Server::libraryGetPicturesOfAlbums(const JsonValue& request, ResponseWriter& response)
 {
     std::vector<int> ids;
 
     requireType(request, "id", Json::arrayValue);
 
-    for (Json::Value::ArrayIndex i = 0; i < request["id"].size(); ++i)
+    for (JsonValue::ArrayIndex i = 0; i < request["id"].size(); ++i)
     {
-	const Json::Value& v = request["id"][i];
+	const JsonValue& v = request["id"][i];
 
 	if (!v.isInt())
 	    throw InvalidMethodCall();
@@ -302,73 +1032,98 @@ void Server::libraryGetPicturesOfAlbums(const Json::Value& request, Json::Value&
 	ids.push_back(v.asInt());
     }
 
-    auto result = m_library->getStorage().getPicturesOfAlbums(ids);
+    // the result is an object keyed by album ids, make sure none of them appears in more than one slice
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
 
-    response = Json::Value(Json::objectValue);
+    response.beginObject();
 
-    for (const auto& it : result)
+    if (ids.empty())
+    {
+	std::map<int, std::shared_ptr<const PictureCache::Pictures>> encoded;
+	encodePicturesOfAlbums(m_library->getStorage().getPicturesOfAlbums(ids), response, encoded);
+
+	for (const auto& it : encoded)
+	    writePicturesOfAlbum(it.first, *it.second, response);
+    }
+
+    // the pictures are cached in the format of the response
+    PictureCache& cache = m_pictureCaches[response.getFormat()];
+
+    // the cached pictures are valid until the next scan, the ones loaded while a scan is in progress may be outdated
+    // soon and they are not stored at all
+    unsigned long long generation = getScanGeneration();
+    bool cacheable = generation != 0;
+
+    for (size_t start = 0; start < ids.size(); start += PICTURE_SLICE_SIZE)
     {
-	Json::Value pictures(Json::arrayValue);
-	pictures.resize(it.second.size());
+	std::vector<int> slice(ids.begin() + start, ids.begin() + std::min(start + PICTURE_SLICE_SIZE, ids.size()));
 
-	Json::Value::ArrayIndex idx = 0;
+	std::map<int, std::shared_ptr<const PictureCache::Pictures>> pictures;
+	std::vector<int> missing;
 
-	for (const auto& pit : it.second)
+	for (int id : slice)
 	{
-	    Json::Value picture(Json::objectValue);
+	    auto p = cacheable ? cache.get(id, generation) : nullptr;
 
-	    switch (pit.first)
-	    {
-		case zeppelin::library::Picture::FrontCover :
-		    picture["type"] = "frontcover";
-		    break;
-		case zeppelin::library::Picture::BackCover :
-		    picture["type"] = "backcover";
-		    break;
-	    }
+	    if (p)
+		pictures[id] = p;
+	    else
+		missing.push_back(id);
+	}
 
-	    picture["mimetype"] = pit.second->getMimeType();
+	if (!missing.empty())
+	{
+	    encodePicturesOfAlbums(m_library->getStorage().getPicturesOfAlbums(missing), response, pictures);
 
-	    // convert the contents of the picture to base64
-	    std::ostringstream os;
-	    std::copy(Base64(&pit.second->getData()[0]),
-		      Base64(&pit.second->getData()[0] + pit.second->getData().size()),
-		      ostream_iterator<char>(os));
-	    picture["data"] = os.str();
+	    for (int id : missing)
+	    {
+		// albums without pictures are remembered as well to avoid asking the storage about them again
+		auto& p = pictures[id];
 
-	    // add the picture to the array
-	    pictures[idx++].swap(picture);
+		if (!p)
+		    p = std::make_shared<const PictureCache::Pictures>();
+
+		if (cacheable)
+		    cache.put(id, generation, p);
+	    }
 	}
 
-	// add the picture list to the object of albums
-	response[std::to_string(it.first)].swap(pictures);
+	for (const auto& it : pictures)
+	{
+	    if (!it.second->empty())
+		writePicturesOfAlbum(it.first, *it.second, response);
+	}
     }
+
+    response.endObject();
 }
 
 // =====================================================================================================================
-void Server::libraryGetAlbumIdsByArtist(const Json::Value& request, Json::Value& response)
+void Server::libraryGetAlbumIdsByArtist(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "artist_id", Json::intValue);
 
     auto albumIds = m_library->getStorage().getAlbumIdsByArtist(request["artist_id"].asInt());
 
-    response = Json::Value(Json::arrayValue);
-    response.resize(albumIds.size());
+    response.beginArray();
+
+    for (int id : albumIds)
+	response.value(id);
 
-    for (Json::Value::ArrayIndex i = 0; i < albumIds.size(); ++i)
-	response[i] = albumIds[i];
+    response.endArray();
 }
 
 // =====================================================================================================================
-void Server::libraryGetFiles(const Json::Value& request, Json::Value& response)
+void Server::libraryGetFiles(const JsonValue& request, ResponseWriter& response)
 {
     std::vector<int> ids;
 
     requireType(request, "id", Json::arrayValue);
 
-    for (Json::Value::ArrayIndex i = 0; i < request["id"].size(); ++i)
+    for (JsonValue::ArrayIndex i = 0; i < request["id"].size(); ++i)
     {
-	const Json::Value& v = request["id"][i];
+	const JsonValue& v = request["id"][i];
 
 	if (!v.isInt())
 	    throw InvalidMethodCall();
@@ -376,58 +1131,65 @@ void Server::libraryGetFiles(const Json::Value& request, Json::Value& response)
 	ids.push_back(v.asInt());
     }
 
-    auto files = m_library->getStorage().getFiles(ids);
+    unsigned fields = selectFields(request, s_fileFields);
 
-    response = Json::Value(Json::arrayValue);
-    response.resize(files.size());
+    // the columns are collected slice by slice as well, only the serialized fields are kept until the end
+    std::unique_ptr<ColumnWriter<zeppelin::library::File>> columns;
 
-    for (Json::Value::ArrayIndex i = 0; i < files.size(); ++i)
+    if (isColumnFormat(request))
+	columns.reset(new ColumnWriter<zeppelin::library::File>(s_fileFields, fields, response));
+    else
+	response.beginArray();
+
+    auto writeFiles = [&](const std::vector<int>& slice)
     {
-	const auto& f = files[i];
+	for (const auto& f : m_library->getStorage().getFiles(slice))
+	{
+	    if (columns)
+		columns->add(*f);
+	    else
+		writeFields(*f, s_fileFields, fields, response);
+	}
+    };
 
-	Json::Value file(Json::objectValue);
-	file["id"] = f->m_id;
-	file["path"] = f->m_path;
-	file["name"] = f->m_name;
-	file["directory_id"] = f->m_directoryId;
-	file["artist_id"] = f->m_artistId;
-	file["album_id"] = f->m_albumId;
-	file["length"] = f->m_metadata->getLength();
-	file["title"] = f->m_metadata->getTitle();
-	file["year"] = f->m_metadata->getYear();
-	file["track_index"] = f->m_metadata->getTrackIndex();
-	file["codec"] = f->m_metadata->getCodec();
-	file["sample_rate"] = f->m_metadata->getSampleRate();
-	file["sample_size"] = f->m_metadata->getSampleSize();
+    // an empty id list selects every file of the library, it can not be split into slices
+    if (ids.empty())
+	writeFiles(ids);
 
-	response[i].swap(file);
-    }
+    for (size_t start = 0; start < ids.size(); start += FILE_SLICE_SIZE)
+	writeFiles(std::vector<int>(ids.begin() + start, ids.begin() + std::min(start + FILE_SLICE_SIZE, ids.size())));
+
+    if (columns)
+	columns->write(response);
+    else
+	response.endArray();
 }
 
 // =====================================================================================================================
-void Server::libraryGetFileIdsOfAlbum(const Json::Value& request, Json::Value& response)
+void Server::libraryGetFileIdsOfAlbum(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "album_id", Json::intValue);
 
     auto fileIds = m_library->getStorage().getFileIdsOfAlbum(request["album_id"].asInt());
 
-    response = Json::Value(Json::arrayValue);
-    response.resize(fileIds.size());
+    response.beginArray();
 
-    for (Json::Value::ArrayIndex i = 0; i < fileIds.size(); ++i)
-	response[i] = fileIds[i];
+    for (int id : fileIds)
+	response.value(id);
+
+    response.endArray();
 }
 
 // =====================================================================================================================
-void Server::libraryGetDirectories(const Json::Value& request, Json::Value& response)
+void Server::libraryGetDirectories(const JsonValue& request, ResponseWriter& response)
 {
     std::vector<int> ids;
 
     requireType(request, "id", Json::arrayValue);
 
-    for (Json::Value::ArrayIndex i = 0; i < request["id"].size(); ++i)
+    for (JsonValue::ArrayIndex i = 0; i < request["id"].size(); ++i)
     {
-	const Json::Value& v = request["id"][i];
+	const JsonValue& v = request["id"][i];
 
 	if (!v.isInt())
 	    throw InvalidMethodCall();
@@ -435,26 +1197,258 @@ void Server::libraryGetDirectories(const Json::Value& request, Json::Value& resp
 	ids.push_back(v.asInt());
     }
 
-    auto directories = m_library->getStorage().getDirectories(ids);
+    writeObjects(m_library->getStorage().getDirectories(ids), s_directoryFields, request, response);
+}
+
+// =====================================================================================================================
+template<typename Load, typename T, size_t N>
+static void writePage(const std::vector<int>& ids,
+		      const JsonValue& request,
+		      Load load,
+		      const Field<T> (&fields)[N],
+		      ResponseWriter& response)
+{
+    size_t limit = DEFAULT_LIST_LIMIT;
+
+    if (request.isMember("limit"))
+    {
+	const JsonValue& v = request["limit"];
+
+	if (!v.isInt() || v.asInt() <= 0)
+	    throw InvalidMethodCall();
+
+	limit = std::min(static_cast<size_t>(v.asInt()), MAX_LIST_LIMIT);
+    }
+
+    // the cursor is the last id of the previous page, the listing continues with the next larger id even if the id
+    // itself was removed from the library meanwhile
+    auto begin = ids.begin();
+
+    if (request.isMember("cursor") && !request["cursor"].isNull())
+    {
+	const JsonValue& cursor = request["cursor"];
+
+	if (!cursor.isString())
+	    throw InvalidMethodCall();
+
+	begin = std::upper_bound(ids.begin(), ids.end(), boost::lexical_cast<int>(cursor.asString()));
+    }
+
+    auto end = begin + std::min(limit, static_cast<size_t>(ids.end() - begin));
+    std::vector<int> page(begin, end);
+
+    response.beginObject();
+
+    response.key("items");
+    // an empty id list would select every object of the library
+    if (page.empty())
+	writeObjects(std::vector<std::shared_ptr<T>>(), fields, request, response);
+    else
+	writeObjects(load(page), fields, request, response);
+
+    response.key("next_cursor");
+    if (end != ids.end())
+	response.value(std::to_string(page.back()));
+    else
+	response.null();
+
+    response.endObject();
+}
+
+// =====================================================================================================================
+void Server::libraryListArtists(const JsonValue& request, ResponseWriter& response)
+{
+    auto index = getIdIndex(m_artistIndex,
+	[this]()
+	{
+	    std::vector<int> ids;
+
+	    for (const auto& a : m_library->getStorage().getArtists({}))
+		ids.push_back(a->m_id);
+
+	    return ids;
+	});
+
+    writePage(*index,
+	      request,
+	      [this](const std::vector<int>& page) { return m_library->getStorage().getArtists(page); },
+	      s_artistFields,
+	      response);
+}
+
+// =====================================================================================================================
+void Server::libraryListAlbums(const JsonValue& request, ResponseWriter& response)
+{
+    auto index = getIdIndex(m_albumIndex,
+	[this]()
+	{
+	    std::vector<int> ids;
+
+	    for (const auto& a : m_library->getStorage().getAlbums({}))
+		ids.push_back(a->m_id);
+
+	    return ids;
+	});
+
+    writePage(*index,
+	      request,
+	      [this](const std::vector<int>& page) { return m_library->getStorage().getAlbums(page); },
+	      s_albumFields,
+	      response);
+}
+
+// =====================================================================================================================
+void Server::libraryListFiles(const JsonValue& request, ResponseWriter& response)
+{
+    auto index = getIdIndex(m_fileIndex,
+	[this]()
+	{
+	    zeppelin::library::Storage& storage = m_library->getStorage();
+	    std::vector<int> ids;
+
+	    // every file belongs to a directory, the ids are collected directory by directory to avoid loading the
+	    // metadata of the whole library
+	    for (const auto& d : storage.getDirectories({}))
+	    {
+		std::vector<int> fileIds = storage.getFileIdsOfDirectory(d->m_id);
+		ids.insert(ids.end(), fileIds.begin(), fileIds.end());
+	    }
+
+	    return ids;
+	});
+
+    writePage(*index,
+	      request,
+	      [this](const std::vector<int>& page) { return m_library->getStorage().getFiles(page); },
+	      s_fileFields,
+	      response);
+}
+
+// =====================================================================================================================
+std::shared_ptr<const std::vector<int>> Server::getIdIndex(IdIndex& index,
+							   const std::function<std::vector<int>()>& load)
+{
+    // the ids are changed by scans only, the index is kept while a scan is running as well to avoid loading the whole
+    // library for every page, it is rebuilt when the scan is finished
+    unsigned long long generation = m_scanGeneration;
+
+    {
+	std::lock_guard<std::mutex> lock(m_indexMutex);
+
+	if (index.m_ids && index.m_generation == generation)
+	    return index.m_ids;
+    }
+
+    // the index is built without holding the lock, calls racing for the same index may build it more than once
+    auto ids = std::make_shared<std::vector<int>>(load());
+    std::sort(ids->begin(), ids->end());
 
-    response = Json::Value(Json::arrayValue);
-    response.resize(directories.size());
+    std::lock_guard<std::mutex> lock(m_indexMutex);
 
-    for (Json::Value::ArrayIndex i = 0; i < directories.size(); ++i)
+    if (generation >= index.m_generation)
     {
-	const auto& d = directories[i];
+	index.m_generation = generation;
+	index.m_ids = ids;
+    }
+
+    return ids;
+}
+
+// =====================================================================================================================
+// the digest covers every field returned to the clients, a change of any of them makes the object modified
+template<typename T, size_t N>
+static uint64_t digestObject(const T& object, const Field<T> (&fields)[N], std::string& buffer)
+{
+    buffer.clear();
+
+    JsonWriter writer(buffer);
+    writeFields(object, fields, allFields(fields), writer);
+
+    return ChangeLog::digest(buffer);
+}
 
-	Json::Value dir(Json::objectValue);
-	dir["id"] = d->m_id;
-	dir["name"] = d->m_name;
-	dir["parent_id"] = d->m_parentId;
+// =====================================================================================================================
+template<typename Objects, typename T, size_t N>
+static void createSnapshot(const Objects& objects, const Field<T> (&fields)[N], ChangeLog::Snapshot& snapshot)
+{
+    std::string buffer;
+
+    snapshot.reserve(objects.size());
+
+    for (const auto& o : objects)
+	snapshot.push_back(std::make_pair(o->m_id, digestObject(*o, fields, buffer)));
 
-	response[i].swap(dir);
+    std::sort(snapshot.begin(), snapshot.end());
+}
+
+// =====================================================================================================================
+static void writeIds(const char* name, const std::vector<int>& ids, ResponseWriter& response)
+{
+    response.key(name);
+    response.beginArray();
+
+    for (int id : ids)
+	response.value(id);
+
+    response.endArray();
+}
+
+// =====================================================================================================================
+static void writeChanges(const char* name, const ChangeLog::Changes& changes, ResponseWriter& response)
+{
+    response.key(name);
+    response.beginObject();
+    writeIds("added", changes.m_added, response);
+    writeIds("modified", changes.m_modified, response);
+    writeIds("deleted", changes.m_deleted, response);
+    response.endObject();
+}
+
+// =====================================================================================================================
+void Server::libraryGetChanges(const JsonValue& request, ResponseWriter& response)
+{
+    if (!request["since"].isIntegral())
+	throw InvalidMethodCall();
+
+    unsigned long long scanGeneration = getScanGeneration();
+
+    // the snapshots are taken when a client asks for the changes after a scan, not while a scan is running, changes
+    // made by the other methods of the server are recorded by the methods themselves
+    if (scanGeneration != 0 && m_changeLog.getScanGeneration() != scanGeneration)
+    {
+	zeppelin::library::Storage& storage = m_library->getStorage();
+	ChangeLog::Snapshot snapshots[ChangeLog::KIND_COUNT];
+
+	createSnapshot(storage.getArtists({}), s_artistFields, snapshots[ChangeLog::ARTIST]);
+	createSnapshot(storage.getAlbums({}), s_albumFields, snapshots[ChangeLog::ALBUM]);
+	createSnapshot(storage.getFiles({}), s_fileFields, snapshots[ChangeLog::FILE]);
+	createSnapshot(storage.getDirectories({}), s_directoryFields, snapshots[ChangeLog::DIRECTORY]);
+
+	m_changeLog.update(scanGeneration, snapshots);
     }
+
+    unsigned long long generation;
+    ChangeLog::Changes changes[ChangeLog::KIND_COUNT];
+    bool complete = m_changeLog.getChanges(request["since"].asUInt64(), generation, changes);
+
+    response.beginObject();
+    response.member("generation", generation);
+    // the client has to download the whole library again if the changes since its generation are not known
+    response.member("reset", !complete);
+
+    if (complete)
+    {
+	writeChanges("artists", changes[ChangeLog::ARTIST], response);
+	writeChanges("albums", changes[ChangeLog::ALBUM], response);
+	writeChanges("files", changes[ChangeLog::FILE], response);
+	writeChanges("directories", changes[ChangeLog::DIRECTORY], response);
+    }
+
+    response.endObject();
 }
 
 // =====================================================================================================================
-void Server::libraryUpdateMetadata(const Json::Value& request, Json::Value& response)
+void Server::libraryUpdateMetadata(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "id", Json::intValue);
 
@@ -467,57 +1461,84 @@ void Server::libraryUpdateMetadata(const Json::Value& request, Json::Value& resp
     file.m_metadata->setYear(request["year"].asInt());
     file.m_metadata->setTrackIndex(request["track_index"].asInt());
 
-    m_library->getStorage().updateFileMetadata(file);
+    m_library->getStorage().updateFileMetadata(file);
+    ++m_libraryGeneration;
+
+    // the file is loaded again to record its new digest, the storage may have changed other fields as well
+    auto files = m_library->getStorage().getFiles({file.m_id});
+
+    if (!files.empty())
+    {
+	std::string buffer;
+	m_changeLog.modify(ChangeLog::FILE, file.m_id, digestObject(*files[0], s_fileFields, buffer));
+    }
+
+    // the artist and the album of the file may be new ones, the old ones may be left without files, and the counts
+    // of both are changed; they are taken from new snapshots of these two small kinds
+    ChangeLog::Snapshot snapshot;
+    createSnapshot(m_library->getStorage().getArtists({}), s_artistFields, snapshot);
+    m_changeLog.modify(ChangeLog::ARTIST, snapshot);
+
+    snapshot.clear();
+    createSnapshot(m_library->getStorage().getAlbums({}), s_albumFields, snapshot);
+    m_changeLog.modify(ChangeLog::ALBUM, snapshot);
+
+    // the listings pick up the new artists and albums with rebuilt indexes
+    std::lock_guard<std::mutex> lock(m_indexMutex);
+    m_artistIndex.m_ids.reset();
+    m_albumIndex.m_ids.reset();
 }
 
 // =====================================================================================================================
-void Server::libraryCreatePlaylist(const Json::Value& request, Json::Value& response)
+void Server::libraryCreatePlaylist(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "name", Json::stringValue);
 
-    response = Json::Value(Json::intValue);
-    response = m_library->getStorage().createPlaylist(request["name"].asString());
+    response.value(m_library->getStorage().createPlaylist(request["name"].asString()));
+    ++m_libraryGeneration;
 }
 
 // =====================================================================================================================
-void Server::libraryDeletePlaylist(const Json::Value& request, Json::Value& response)
+void Server::libraryDeletePlaylist(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "id", Json::intValue);
 
     m_library->getStorage().deletePlaylist(request["id"].asInt());
+    ++m_libraryGeneration;
 }
 
 // =====================================================================================================================
-void Server::libraryAddPlaylistItem(const Json::Value& request, Json::Value& response)
+void Server::libraryAddPlaylistItem(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "id", Json::intValue);
     requireType(request, "type", Json::stringValue);
     requireType(request, "item_id", Json::intValue);
 
-    response = Json::Value(Json::intValue);
-    response = m_library->getStorage().addPlaylistItem(request["id"].asInt(),
-						       request["type"].asString(),
-						       request["item_id"].asInt());
+    response.value(m_library->getStorage().addPlaylistItem(request["id"].asInt(),
+							   request["type"].asString(),
+							   request["item_id"].asInt()));
+    ++m_libraryGeneration;
 }
 
 // =====================================================================================================================
-void Server::libraryDeletePlaylistItem(const Json::Value& request, Json::Value& response)
+void Server::libraryDeletePlaylistItem(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "id", Json::intValue);
 
     m_library->getStorage().deletePlaylistItem(request["id"].asInt());
+    ++m_libraryGeneration;
 }
 
 // =====================================================================================================================
-void Server::libraryGetPlaylists(const Json::Value& request, Json::Value& response)
+void Server::libraryGetPlaylists(const JsonValue& request, ResponseWriter& response)
 {
     std::vector<int> ids;
 
     requireType(request, "id", Json::arrayValue);
 
-    for (Json::Value::ArrayIndex i = 0; i < request["id"].size(); ++i)
+    for (JsonValue::ArrayIndex i = 0; i < request["id"].size(); ++i)
     {
-	const Json::Value& v = request["id"][i];
+	const JsonValue& v = request["id"][i];
 
 	if (!v.isInt())
 	    throw InvalidMethodCall();
@@ -527,38 +1548,41 @@ void Server::libraryGetPlaylists(const Json::Value& request, Json::Value& respon
 
     auto playlists = m_library->getStorage().getPlaylists(ids);
 
-    response = Json::Value(Json::arrayValue);
-    response.resize(playlists.size());
+    response.beginArray();
 
-    for (Json::Value::ArrayIndex i = 0; i < playlists.size(); ++i)
+    for (const auto& p : playlists)
     {
-	const auto& p = playlists[i];
-
-	Json::Value playlist(Json::objectValue);
-	playlist["id"] = p->m_id;
-	playlist["name"] = p->m_name;
+	response.beginObject();
+	response.member("id", p->m_id);
+	response.member("name", p->m_name);
 
-	playlist["items"] = Json::Value(Json::arrayValue);
-	playlist["items"].resize(p->m_items.size());
+	response.key("items");
+	response.beginArray();
 
-	for (Json::Value::ArrayIndex j = 0; j < p->m_items.size(); ++j)
+	for (const auto& pi : p->m_items)
 	{
-	    const auto& pi = p->m_items[j];
-
-	    Json::Value item(Json::objectValue);
-	    item["id"] = pi.m_id;
-	    item["type"] = pi.m_type;
-	    item["item_id"] = pi.m_itemId;
-
-	    playlist["items"][j].swap(item);
+	    response.beginObject();
+	    response.member("id", pi.m_id);
+	    response.member("type", pi.m_type);
+	    response.member("item_id", pi.m_itemId);
+	    response.endObject();
 	}
 
-	response[i].swap(playlist);
+	response.endArray();
+	response.endObject();
     }
+
+    response.endArray();
+}
+
+// =====================================================================================================================
+void Server::queue(const std::shared_ptr<zeppelin::player::QueueItem>& item)
+{
+    m_jobs.run([this, &item]() { m_ctrl->queue(item); });
 }
 
 // =====================================================================================================================
-void Server::playerQueueFile(const Json::Value& request, Json::Value& response)
+void Server::playerQueueFile(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "id", Json::intValue);
 
@@ -567,61 +1591,129 @@ void Server::playerQueueFile(const Json::Value& request, Json::Value& response)
     if (files.empty())
 	throw InvalidMethodCall();
 
-    m_ctrl->queue(std::make_shared<zeppelin::player::File>(files[0]));
+    queue(std::make_shared<zeppelin::player::File>(files[0]));
 }
 
 // =====================================================================================================================
-void Server::playerQueueDirectory(const Json::Value& request, Json::Value& response)
+// returns true if the client asked for building the queue item in the background
+static bool isAsync(const JsonValue& request)
 {
-    requireType(request, "id", Json::intValue);
+    if (!request.isMember("async"))
+	return false;
+
+    if (!request["async"].isBool())
+	throw InvalidMethodCall();
 
-    m_ctrl->queue(createDirectory(request["id"].asInt()));
+    return request["async"].asBool();
 }
 
 // =====================================================================================================================
-void Server::playerQueueAlbum(const Json::Value& request, Json::Value& response)
+void Server::playerQueueDirectory(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "id", Json::intValue);
 
-    m_ctrl->queue(createAlbum(request["id"].asInt()));
+    int directoryId = request["id"].asInt();
+
+    if (!isAsync(request))
+    {
+	queue(createDirectory(directoryId));
+	return;
+    }
+
+    int job = m_jobs.submit(
+	[this, directoryId](const std::atomic<bool>& cancelled)
+	{
+	    auto dir = createDirectory(directoryId);
+
+	    if (cancelled)
+		return false;
+
+	    m_ctrl->queue(dir);
+	    return true;
+	});
+
+    response.beginObject();
+    response.member("job_id", job);
+    response.endObject();
 }
 
 // =====================================================================================================================
-void Server::playerQueuePlaylist(const Json::Value& request, Json::Value& response)
+void Server::playerQueueAlbum(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "id", Json::intValue);
 
-    auto playlists = m_library->getStorage().getPlaylists({request["id"].asInt()});
+    queue(createAlbum(request["id"].asInt()));
+}
 
-    if (playlists.empty())
-	throw InvalidMethodCall();
+// =====================================================================================================================
+void Server::playerQueueAlbums(const JsonValue& request, ResponseWriter& response)
+{
+    std::vector<int> ids;
 
-    std::shared_ptr<zeppelin::player::Playlist> p = std::make_shared<zeppelin::player::Playlist>(playlists[0]->m_id);
+    requireType(request, "id", Json::arrayValue);
 
-    for (const auto& item : playlists[0]->m_items)
+    for (JsonValue::ArrayIndex i = 0; i < request["id"].size(); ++i)
     {
-	if (item.m_type == "file")
+	const JsonValue& v = request["id"][i];
+
+	if (!v.isInt())
+	    throw InvalidMethodCall();
+
+	ids.push_back(v.asInt());
+    }
+
+    auto albums = createAlbums(ids);
+
+    // nothing is queued if any of the albums is unknown
+    for (const auto& album : albums)
+    {
+	if (!album)
+	    throw InvalidMethodCall();
+    }
+
+    m_jobs.run(
+	[this, &albums]()
 	{
-	    auto files = m_library->getStorage().getFiles({item.m_itemId});
+	    for (const auto& album : albums)
+		m_ctrl->queue(album);
+	});
+}
 
-	    if (!files.empty())
-		p->add(std::make_shared<zeppelin::player::File>(files[0]));
-	}
-	else if (item.m_type == "directory")
-	    p->add(createDirectory(item.m_itemId));
-	else if (item.m_type == "album")
-	    p->add(createAlbum(item.m_itemId));
-	else
-	    LOG("jsonrpc-remote: invalid playlist item: " << item.m_type);
+// =====================================================================================================================
+void Server::playerQueuePlaylist(const JsonValue& request, ResponseWriter& response)
+{
+    requireType(request, "id", Json::intValue);
+
+    int playlistId = request["id"].asInt();
+
+    if (!isAsync(request))
+    {
+	queue(createPlaylist(playlistId));
+	return;
     }
 
-    m_ctrl->queue(p);
+    int job = m_jobs.submit(
+	[this, playlistId](const std::atomic<bool>& cancelled)
+	{
+	    auto playlist = createPlaylist(playlistId);
+
+	    if (cancelled)
+		return false;
+
+	    m_ctrl->queue(playlist);
+	    return true;
+	});
+
+    response.beginObject();
+    response.member("job_id", job);
+    response.endObject();
 }
 
 // =====================================================================================================================
-static inline void serializeQueueItem(Json::Value& parent, const std::shared_ptr<zeppelin::player::QueueItem>& item)
+static inline void serializeQueueItem(ResponseWriter& response,
+				      const std::shared_ptr<zeppelin::player::QueueItem>& item)
 {
-    Json::Value qi(Json::objectValue);
+    response.beginObject();
 
     switch (item->type())
     {
@@ -629,12 +1721,16 @@ static inline void serializeQueueItem(Json::Value& parent, const std::shared_ptr
 	{
 	    const zeppelin::player::Playlist& pl = static_cast<const zeppelin::player::Playlist&>(*item);
 
-	    qi["type"] = "playlist";
-	    qi["id"] = pl.getId();
-	    qi["items"] = Json::Value(Json::arrayValue);
+	    response.member("type", "playlist");
+	    response.member("id", pl.getId());
+
+	    response.key("items");
+	    response.beginArray();
 
 	    for (const auto& i : pl.items())
-		serializeQueueItem(qi["items"], i);
+		serializeQueueItem(response, i);
+
+	    response.endArray();
 
 	    break;
 	}
@@ -644,12 +1740,16 @@ static inline void serializeQueueItem(Json::Value& parent, const std::shared_ptr
 	    const zeppelin::player::Directory& di = static_cast<const zeppelin::player::Directory&>(*item);
 	    const zeppelin::library::Directory& directory = di.directory();
 
-	    qi["type"] = "directory";
-	    qi["id"] = directory.m_id;
-	    qi["files"] = Json::Value(Json::arrayValue);
+	    response.member("type", "directory");
+	    response.member("id", directory.m_id);
+
+	    response.key("files");
+	    response.beginArray();
 
 	    for (const auto& i : di.items())
-		serializeQueueItem(qi["files"], i);
+		serializeQueueItem(response, i);
+
+	    response.endArray();
 
 	    break;
 	}
@@ -659,12 +1759,16 @@ static inline void serializeQueueItem(Json::Value& parent, const std::shared_ptr
 	    const zeppelin::player::Album& ai = static_cast<const zeppelin::player::Album&>(*item);
 	    const zeppelin::library::Album& album = ai.album();
 
-	    qi["type"] = "album";
-	    qi["id"] = album.m_id;
-	    qi["files"] = Json::Value(Json::arrayValue);
+	    response.member("type", "album");
+	    response.member("id", album.m_id);
+
+	    response.key("files");
+	    response.beginArray();
 
 	    for (const auto& i : ai.items())
-		serializeQueueItem(qi["files"], i);
+		serializeQueueItem(response, i);
+
+	    response.endArray();
 
 	    break;
 	}
@@ -673,39 +1777,41 @@ static inline void serializeQueueItem(Json::Value& parent, const std::shared_ptr
 	{
 	    auto file = item->file();
 
-	    qi["type"] = "file";
-	    qi["id"] = file->m_id;
+	    response.member("type", "file");
+	    response.member("id", file->m_id);
 
 	    break;
 	}
     }
 
-    parent.append(qi);
+    response.endObject();
 }
 
 // =====================================================================================================================
-void Server::playerQueueGet(const Json::Value& request, Json::Value& response)
+void Server::playerQueueGet(const JsonValue& request, ResponseWriter& response)
 {
     auto queue = m_ctrl->getQueue();
 
-    response = Json::Value(Json::arrayValue);
+    response.beginArray();
 
     for (const auto& item : queue->items())
 	serializeQueueItem(response, item);
+
+    response.endArray();
 }
 
 // =====================================================================================================================
-void Server::playerQueueRemove(const Json::Value& request, Json::Value& response)
+void Server::playerQueueRemove(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "index", Json::arrayValue);
 
-    Json::Value index = request["index"];
+    const JsonValue& index = request["index"];
 
     std::vector<int> i;
 
-    for (Json::Value::ArrayIndex j = 0; j < index.size(); ++j)
+    for (JsonValue::ArrayIndex j = 0; j < index.size(); ++j)
     {
-	const Json::Value& item = index[j];
+	const JsonValue& item = index[j];
 
 	// make sure index contains only integers
 	if (!item.isInt())
@@ -714,52 +1820,115 @@ void Server::playerQueueRemove(const Json::Value& request, Json::Value& response
 	i.push_back(item.asInt());
     }
 
-    m_ctrl->remove(i);
+    m_jobs.run([this, &i]() { m_ctrl->remove(i); });
+}
+
+// =====================================================================================================================
+void Server::playerQueueRemoveAll(const JsonValue& request, ResponseWriter& response)
+{
+    m_jobs.run([this]() { m_ctrl->removeAll(); });
 }
 
 // =====================================================================================================================
-void Server::playerQueueRemoveAll(const Json::Value& request, Json::Value& response)
+// Writes the members of the status object. If the previous status is given only the members differing from it are
+// written.
+static inline void writeStatus(ResponseWriter& response,
+			       const zeppelin::player::Controller::Status& s,
+			       const zeppelin::player::Controller::Status* previous)
 {
-    m_ctrl->removeAll();
+    int current = s.m_file ? s.m_file->m_id : -1;
+
+    if (!previous || current != (previous->m_file ? previous->m_file->m_id : -1))
+    {
+	response.key("current");
+	if (s.m_file)
+	    response.value(current);
+	else
+	    response.null();
+    }
+
+    if (!previous || s.m_state != previous->m_state)
+	response.member("state", static_cast<int>(s.m_state));
+    if (!previous || s.m_position != previous->m_position)
+	response.member("position", s.m_position);
+    if (!previous || s.m_volume != previous->m_volume)
+	response.member("volume", s.m_volume);
+
+    if (!previous || s.m_index != previous->m_index)
+    {
+	response.key("index");
+	response.beginArray();
+	for (int i : s.m_index)
+	    response.value(i);
+	response.endArray();
+    }
 }
 
 // =====================================================================================================================
-void Server::playerStatus(const Json::Value& request, Json::Value& response)
+void Server::playerStatus(const JsonValue& request, ResponseWriter& response)
 {
     zeppelin::player::Controller::Status s = m_ctrl->getStatus();
 
-    response = Json::Value(Json::objectValue);
+    response.beginObject();
+    writeStatus(response, s, nullptr);
+    response.endObject();
+}
+
+// =====================================================================================================================
+void Server::playerWaitStatus(const JsonValue& request, ResponseWriter& response)
+{
+    // without a version the current status is returned right away
+    unsigned long long version = 0;
+
+    if (request.isMember("version"))
+    {
+	if (!request["version"].isIntegral())
+	    throw InvalidMethodCall();
+
+	version = request["version"].asUInt64();
+    }
+
+    int timeout = DEFAULT_WAIT_STATUS_TIMEOUT;
+
+    if (request.isMember("timeout"))
+    {
+	requireType(request, "timeout", Json::intValue);
+	timeout = std::max(0, std::min(request["timeout"].asInt(), MAX_WAIT_STATUS_TIMEOUT));
+    }
+
+    StatusWatcher::Change change = m_statusWatcher.wait(version, timeout);
+
+    response.beginObject();
+    response.member("version", change.m_version);
 
-    response["current"] = s.m_file ? Json::Value(s.m_file->m_id) : Json::Value(Json::nullValue);
-    response["state"] = static_cast<int>(s.m_state);
-    response["position"] = s.m_position;
-    response["volume"] = s.m_volume;
-    response["index"] = Json::Value(Json::arrayValue);
-    response["index"].resize(s.m_index.size());
-    for (Json::Value::ArrayIndex i = 0; i < s.m_index.size(); ++i)
-	response["index"][i] = s.m_index[i];
+    response.key("status");
+    response.beginObject();
+    writeStatus(response, change.m_status, change.m_hasPrevious ? &change.m_previous : nullptr);
+    response.endObject();
+
+    response.endObject();
 }
 
 // =====================================================================================================================
-void Server::playerPlay(const Json::Value& request, Json::Value& response)
+void Server::playerPlay(const JsonValue& request, ResponseWriter& response)
 {
     m_ctrl->play();
 }
 
 // =====================================================================================================================
-void Server::playerPause(const Json::Value& request, Json::Value& response)
+void Server::playerPause(const JsonValue& request, ResponseWriter& response)
 {
     m_ctrl->pause();
 }
 
 // =====================================================================================================================
-void Server::playerStop(const Json::Value& request, Json::Value& response)
+void Server::playerStop(const JsonValue& request, ResponseWriter& response)
 {
     m_ctrl->stop();
 }
 
 // =====================================================================================================================
-void Server::playerSeek(const Json::Value& request, Json::Value& response)
+void Server::playerSeek(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "seconds", Json::intValue);
 
@@ -767,29 +1936,29 @@ void Server::playerSeek(const Json::Value& request, Json::Value& response)
 }
 
 // =====================================================================================================================
-void Server::playerPrev(const Json::Value& request, Json::Value& response)
+void Server::playerPrev(const JsonValue& request, ResponseWriter& response)
 {
     m_ctrl->prev();
 }
 
 // =====================================================================================================================
-void Server::playerNext(const Json::Value& request, Json::Value& response)
+void Server::playerNext(const JsonValue& request, ResponseWriter& response)
 {
     m_ctrl->next();
 }
 
 // =====================================================================================================================
-void Server::playerGoto(const Json::Value& request, Json::Value& response)
+void Server::playerGoto(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "index", Json::arrayValue);
 
-    Json::Value index = request["index"];
+    const JsonValue& index = request["index"];
 
     std::vector<int> i;
 
-    for (Json::UInt j = 0; j < index.size(); ++j)
+    for (JsonValue::ArrayIndex j = 0; j < index.size(); ++j)
     {
-	const Json::Value& item = index[j];
+	const JsonValue& item = index[j];
 
 	// make sure index contains only integers
 	if (!item.isInt())
@@ -802,13 +1971,13 @@ void Server::playerGoto(const Json::Value& request, Json::Value& response)
 }
 
 // =====================================================================================================================
-void Server::playerGetVolume(const Json::Value& request, Json::Value& response)
+void Server::playerGetVolume(const JsonValue& request, ResponseWriter& response)
 {
-    response = m_ctrl->getVolume();
+    response.value(m_ctrl->getVolume());
 }
 
 // =====================================================================================================================
-void Server::playerSetVolume(const Json::Value& request, Json::Value& response)
+void Server::playerSetVolume(const JsonValue& request, ResponseWriter& response)
 {
     requireType(request, "level", Json::intValue);
 
@@ -816,7 +1985,40 @@ void Server::playerSetVolume(const Json::Value& request, Json::Value& response)
 }
 
 // =====================================================================================================================
-void Server::requireType(const Json::Value& request, const std::string& key, Json::ValueType type)
+void Server::jobStatus(const JsonValue& request, ResponseWriter& response)
+{
+    requireType(request, "id", Json::intValue);
+
+    JobQueue::State state;
+    std::string error;
+
+    if (!m_jobs.getState(request["id"].asInt(), state, error))
+	throw InvalidMethodCall();
+
+    response.beginObject();
+    response.member("id", request["id"]);
+    response.member("state", JobQueue::stateName(state));
+    if (state == JobQueue::FAILED)
+	response.member("error", error);
+    response.endObject();
+}
+
+// =====================================================================================================================
+void Server::jobCancel(const JsonValue& request, ResponseWriter& response)
+{
+    requireType(request, "id", Json::intValue);
+
+    response.value(m_jobs.cancel(request["id"].asInt()));
+}
+
+// =====================================================================================================================
+void Server::serverGetMetrics(const JsonValue& request, ResponseWriter& response)
+{
+    m_metrics.write(response);
+}
+
+// =====================================================================================================================
+void Server::requireType(const JsonValue& request, const char* key, Json::ValueType type)
 {
     if (!request.isMember(key) || request[key].type() != type)
 	throw InvalidMethodCall();
@@ -825,77 +2027,333 @@ void Server::requireType(const Json::Value& request, const std::string& key, Jso
 // =====================================================================================================================
 std::shared_ptr<zeppelin::player::Album> Server::createAlbum(int albumId)
 {
-    auto albums = m_library->getStorage().getAlbums({albumId});
+    auto albums = createAlbums({albumId});
+
+    if (!albums[0])
+	throw InvalidMethodCall();
+
+    return albums[0];
+}
+
+// =====================================================================================================================
+std::vector<std::shared_ptr<zeppelin::player::Album>> Server::createAlbums(const std::vector<int>& albumIds)
+{
+    std::vector<std::shared_ptr<zeppelin::player::Album>> result(albumIds.size());
+
+    // an empty list of ids would select every album of the library
+    if (albumIds.empty())
+	return result;
+
+    zeppelin::library::Storage& storage = m_library->getStorage();
+
+    std::unordered_map<int, std::shared_ptr<zeppelin::library::Album>> albums;
+
+    for (const auto& a : storage.getAlbums(albumIds))
+	albums[a->m_id] = a;
+
+    // the storage can list the files of one album at a time only, but the files themselves are loaded at once
+    std::unordered_map<int, std::vector<int>> albumFileIds;
+    std::vector<int> fileIds;
+
+    for (const auto& it : albums)
+    {
+	std::vector<int>& ids = albumFileIds[it.first];
+
+	ids = storage.getFileIdsOfAlbum(it.first);
+	fileIds.insert(fileIds.end(), ids.begin(), ids.end());
+    }
+
+    std::unordered_map<int, std::shared_ptr<zeppelin::library::File>> files;
+
+    if (!fileIds.empty())
+    {
+	for (const auto& f : storage.getFiles(fileIds))
+	    files[f->m_id] = f;
+    }
+
+    for (size_t i = 0; i < albumIds.size(); ++i)
+    {
+	auto ait = albums.find(albumIds[i]);
+
+	if (ait == albums.end())
+	    continue;
+
+	std::vector<std::shared_ptr<zeppelin::library::File>> albumFiles;
+
+	for (int id : albumFileIds[albumIds[i]])
+	{
+	    auto fit = files.find(id);
+
+	    if (fit != files.end())
+		albumFiles.push_back(fit->second);
+	}
+
+	std::sort(
+	    albumFiles.begin(),
+	    albumFiles.end(),
+	    [](const std::shared_ptr<zeppelin::library::File>& f1, const std::shared_ptr<zeppelin::library::File>& f2)
+	    {
+		return (f1->m_metadata->getTrackIndex() < f2->m_metadata->getTrackIndex()) ||
+		    ((f1->m_metadata->getTrackIndex() == f2->m_metadata->getTrackIndex()) && (f1->m_name < f2->m_name));
+	    });
+
+	result[i] = std::make_shared<zeppelin::player::Album>(ait->second, albumFiles);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+std::shared_ptr<zeppelin::player::Playlist> Server::createPlaylist(int playlistId)
+{
+    zeppelin::library::Storage& storage = m_library->getStorage();
+
+    auto playlists = storage.getPlaylists({playlistId});
 
-    if (albums.empty())
+    if (playlists.empty())
 	throw InvalidMethodCall();
 
-    auto fileIds = m_library->getStorage().getFileIdsOfAlbum(albumId);
-    auto files = m_library->getStorage().getFiles(fileIds);
+    const auto& items = playlists[0]->m_items;
+
+    // the items are grouped by their type to load each kind with a single query, the playlist is assembled in the
+    // original order afterwards
+    std::vector<int> fileIds;
+    std::vector<int> directoryIds;
+    std::vector<int> albumIds;
+
+    for (const auto& item : items)
+    {
+	if (item.m_type == "file")
+	    fileIds.push_back(item.m_itemId);
+	else if (item.m_type == "directory")
+	    directoryIds.push_back(item.m_itemId);
+	else if (item.m_type == "album")
+	    albumIds.push_back(item.m_itemId);
+    }
+
+    std::unordered_map<int, std::shared_ptr<zeppelin::library::File>> files;
+
+    if (!fileIds.empty())
+    {
+	for (const auto& f : storage.getFiles(fileIds))
+	    files[f->m_id] = f;
+    }
+
+    auto directories = createDirectories(directoryIds);
+    size_t nextDirectory = 0;
 
-    std::sort(
-	files.begin(),
-	files.end(),
-	[](const std::shared_ptr<zeppelin::library::File>& f1, const std::shared_ptr<zeppelin::library::File>& f2)
+    auto albums = createAlbums(albumIds);
+    size_t nextAlbum = 0;
+
+    std::shared_ptr<zeppelin::player::Playlist> p = std::make_shared<zeppelin::player::Playlist>(playlists[0]->m_id);
+
+    for (const auto& item : items)
+    {
+	if (item.m_type == "file")
 	{
-	    return (f1->m_metadata->getTrackIndex() < f2->m_metadata->getTrackIndex()) ||
-		((f1->m_metadata->getTrackIndex() == f2->m_metadata->getTrackIndex()) && (f1->m_name < f2->m_name));
-	});
+	    auto it = files.find(item.m_itemId);
+
+	    if (it != files.end())
+		p->add(std::make_shared<zeppelin::player::File>(it->second));
+	}
+	else if (item.m_type == "directory")
+	{
+	    const auto& dir = directories[nextDirectory++];
+
+	    if (!dir)
+		throw InvalidMethodCall();
+
+	    p->add(dir);
+	}
+	else if (item.m_type == "album")
+	{
+	    const auto& album = albums[nextAlbum++];
+
+	    if (!album)
+		throw InvalidMethodCall();
 
-    return std::make_shared<zeppelin::player::Album>(
-	albums[0],
-	fileIds.empty() ?
-	    std::vector<std::shared_ptr<zeppelin::library::File>>() :
-	    files);
+	    p->add(album);
+	}
+	else
+	    LOG("jsonrpc-remote: invalid playlist item: " << item.m_type);
+    }
+
+    return p;
 }
 
 // =====================================================================================================================
 std::shared_ptr<zeppelin::player::Directory> Server::createDirectory(int directoryId)
 {
-    auto directories = m_library->getStorage().getDirectories({directoryId});
+    auto directories = createDirectories({directoryId});
 
-    if (directories.empty())
+    if (!directories[0])
 	throw InvalidMethodCall();
 
-    auto dir = std::make_shared<zeppelin::player::Directory>(directories[0]);
+    return directories[0];
+}
+
+// =====================================================================================================================
+std::vector<std::shared_ptr<zeppelin::player::Directory>>
+Server::createDirectories(const std::vector<int>& directoryIds)
+{
+    std::vector<std::shared_ptr<zeppelin::player::Directory>> result(directoryIds.size());
+
+    if (directoryIds.empty())
+	return result;
+
+    zeppelin::library::Storage& storage = m_library->getStorage();
+
+    std::unordered_map<int, std::shared_ptr<zeppelin::library::Directory>> directories;
+    std::unordered_map<int, std::vector<std::shared_ptr<zeppelin::library::Directory>>> children;
+    std::unordered_map<int, std::vector<std::shared_ptr<zeppelin::library::File>>> files;
 
-    // subdirectories
-    auto dirIds = m_library->getStorage().getSubdirectoryIdsOfDirectory(directoryId);
+    // the trees are walked level by level without recursion to handle arbitrarily deep trees, the directories and the
+    // files of a level are loaded with one query each; directories shared by several of the requested trees are
+    // visited once
+    std::vector<int> level;
+    std::unordered_set<int> visited;
 
-    if (!dirIds.empty())
+    for (int id : directoryIds)
     {
-	auto dirs = m_library->getStorage().getDirectories(dirIds);
+	if (visited.insert(id).second)
+	    level.push_back(id);
+    }
 
-	std::sort(
-	    dirs.begin(),
-	    dirs.end(),
-	    [](const std::shared_ptr<zeppelin::library::Directory>& d1, const std::shared_ptr<zeppelin::library::Directory>& d2)
+    for (const auto& d : storage.getDirectories(level))
+	directories[d->m_id] = d;
+
+    while (!level.empty())
+    {
+	// the storage can list the subdirectories and the files of one directory at a time only
+	std::unordered_map<int, std::vector<int>> subdirectoryIds;
+	std::unordered_map<int, std::vector<int>> directoryFileIds;
+	std::vector<int> nextLevel;
+	std::vector<int> fileIds;
+
+	for (int id : level)
+	{
+	    if (directories.find(id) == directories.end())
+		continue;
+
+	    std::vector<int>& subdirs = subdirectoryIds[id];
+	    subdirs = storage.getSubdirectoryIdsOfDirectory(id);
+
+	    for (int subdir : subdirs)
 	    {
-		return d1->m_name < d2->m_name;
-	    });
+		if (visited.insert(subdir).second)
+		    nextLevel.push_back(subdir);
+	    }
 
-	for (const auto& d : dirs)
-	    dir->add(createDirectory(d->m_id));
-    }
+	    std::vector<int>& ids = directoryFileIds[id];
+	    ids = storage.getFileIdsOfDirectory(id);
+	    fileIds.insert(fileIds.end(), ids.begin(), ids.end());
+	}
 
-    // files
-    auto fileIds = m_library->getStorage().getFileIdsOfDirectory(directoryId);
+	if (!nextLevel.empty())
+	{
+	    for (const auto& d : storage.getDirectories(nextLevel))
+		directories[d->m_id] = d;
+	}
 
-    if (!fileIds.empty())
+	std::unordered_map<int, std::shared_ptr<zeppelin::library::File>> levelFiles;
+
+	if (!fileIds.empty())
+	{
+	    for (const auto& f : storage.getFiles(fileIds))
+		levelFiles[f->m_id] = f;
+	}
+
+	for (const auto& it : subdirectoryIds)
+	{
+	    std::vector<std::shared_ptr<zeppelin::library::Directory>>& c = children[it.first];
+
+	    for (int id : it.second)
+	    {
+		auto dit = directories.find(id);
+
+		if (dit != directories.end())
+		    c.push_back(dit->second);
+	    }
+
+	    std::sort(
+		c.begin(),
+		c.end(),
+		[](const std::shared_ptr<zeppelin::library::Directory>& d1,
+		   const std::shared_ptr<zeppelin::library::Directory>& d2)
+		{
+		    return d1->m_name < d2->m_name;
+		});
+	}
+
+	for (const auto& it : directoryFileIds)
+	{
+	    std::vector<std::shared_ptr<zeppelin::library::File>>& f = files[it.first];
+
+	    for (int id : it.second)
+	    {
+		auto fit = levelFiles.find(id);
+
+		if (fit != levelFiles.end())
+		    f.push_back(fit->second);
+	    }
+
+	    std::sort(
+		f.begin(),
+		f.end(),
+		[](const std::shared_ptr<zeppelin::library::File>& f1, const std::shared_ptr<zeppelin::library::File>& f2)
+		{
+		    return f1->m_name < f2->m_name;
+		});
+	}
+
+	level.swap(nextLevel);
+    }
+
+    // assemble a separate tree for every requested id, the subdirectories of a directory come first and its files
+    // after them both ordered by name
+    for (size_t i = 0; i < directoryIds.size(); ++i)
     {
-	auto files = m_library->getStorage().getFiles(fileIds);
+	auto root = directories.find(directoryIds[i]);
 
-	std::sort(
-	    files.begin(),
-	    files.end(),
-	    [](const std::shared_ptr<zeppelin::library::File>& f1, const std::shared_ptr<zeppelin::library::File>& f2)
+	if (root == directories.end())
+	    continue;
+
+	result[i] = std::make_shared<zeppelin::player::Directory>(root->second);
+
+	std::vector<std::shared_ptr<zeppelin::player::Directory>> pending(1, result[i]);
+	std::vector<int> pendingIds(1, directoryIds[i]);
+
+	while (!pending.empty())
+	{
+	    std::shared_ptr<zeppelin::player::Directory> dir = pending.back();
+	    int id = pendingIds.back();
+
+	    pending.pop_back();
+	    pendingIds.pop_back();
+
+	    auto cit = children.find(id);
+
+	    if (cit != children.end())
 	    {
-		return f1->m_name < f2->m_name;
-	    });
+		for (const auto& child : cit->second)
+		{
+		    auto subdir = std::make_shared<zeppelin::player::Directory>(child);
+		    dir->add(subdir);
+
+		    pending.push_back(subdir);
+		    pendingIds.push_back(child->m_id);
+		}
+	    }
 
-	for (const auto& f : files)
-	    dir->add(std::make_shared<zeppelin::player::File>(f));
+	    auto fit = files.find(id);
+
+	    if (fit != files.end())
+	    {
+		for (const auto& f : fit->second)
+		    dir->add(std::make_shared<zeppelin::player::File>(f));
+	    }
+	}
     }
 
-    return dir;
+    return result;
 }
@@ -14,10 +14,24 @@
 #include <zeppelin/player/controller.h>
 #include <zeppelin/player/queue.h>
 
+#include "threadpool.h"
+#include "responsewriter.h"
+#include "jsonvalue.h"
+#include "arena.h"
+#include "picturecache.h"
+#include "statuswatcher.h"
+#include "scanwatcher.h"
+#include "changelog.h"
+#include "metrics.h"
+#include "jobqueue.h"
+
 #include <jsoncpp/json/value.h>
 
-#include <unordered_map>
 #include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <functional>
 
 class InvalidMethodCall : public std::runtime_error
 {
@@ -39,72 +53,197 @@ class Server : public zeppelin::plugin::Plugin
 	void start(const Json::Value& config, zeppelin::plugin::PluginManager& pm) override;
 	void stop() override;
 
+	// executes the JSON-RPC call(s) of the given request body and returns the response serialized in the same format,
+	// it is public to allow driving the server without the HTTP server plugin (see bench/server.cpp)
+	std::string processBody(const std::string& data, Arena& arena, ResponseWriter::Format format);
+
     private:
 	std::unique_ptr<httpserver::HttpResponse> processRequest(const httpserver::HttpRequest& request);
-
-	void libraryScan(const Json::Value& request, Json::Value& response);
-	void libraryGetStatus(const Json::Value& request, Json::Value& response);
-	void libraryGetStatistics(const Json::Value& request, Json::Value& response);
+	// the same as processRequest, but the response is compressed with gzip if it is large enough
+	std::unique_ptr<httpserver::HttpResponse> processCompressedRequest(const httpserver::HttpRequest& request);
+	// the same as processRequest, but both the request and the response are encoded with MessagePack
+	std::unique_ptr<httpserver::HttpResponse> processMsgPackRequest(const httpserver::HttpRequest& request);
+	// serves the raw contents of an album picture selected by the album_id and type members of the JSON body
+	std::unique_ptr<httpserver::HttpResponse> processPictureRequest(const httpserver::HttpRequest& request);
+	// serves the call counters and latency histograms in the text format of Prometheus
+	std::unique_ptr<httpserver::HttpResponse> processMetricsRequest(const httpserver::HttpRequest& request);
+	std::unique_ptr<httpserver::HttpResponse> createReply(const httpserver::HttpRequest& httpReq,
+							      const std::string& body,
+							      ResponseWriter::Format format,
+							      bool compress);
+	void processBatch(const JsonValue& calls, ResponseWriter& response, Arena& arena);
+	void processCall(const JsonValue& call, ResponseWriter& response);
+
+	bool isReadOnlyCall(const JsonValue& call) const;
+
+	// returns the current generation of the library contents or 0 if they are being changed by a scan right now
+	unsigned long long getLibraryGeneration();
+	// the same as getLibraryGeneration, but it is changed by scans only, not by the playlist and metadata methods
+	unsigned long long getScanGeneration();
+
+	void libraryScan(const JsonValue& request, ResponseWriter& response);
+	void libraryGetStatus(const JsonValue& request, ResponseWriter& response);
+	void libraryGetStatistics(const JsonValue& request, ResponseWriter& response);
 
 	// library - artists
-	void libraryGetArtists(const Json::Value& request, Json::Value& response);
+	void libraryGetArtists(const JsonValue& request, ResponseWriter& response);
 
 	// library - albums
-	void libraryGetAlbumIdsByArtist(const Json::Value& request, Json::Value& response);
-	void libraryGetAlbums(const Json::Value& request, Json::Value& response);
-	void libraryGetPicturesOfAlbums(const Json::Value& request, Json::Value& response);
+	void libraryGetAlbumIdsByArtist(const JsonValue& request, ResponseWriter& response);
+	void libraryGetAlbums(const JsonValue& request, ResponseWriter& response);
+	void libraryGetPicturesOfAlbums(const JsonValue& request, ResponseWriter& response);
 
 	// library - files
-	void libraryGetFiles(const Json::Value& request, Json::Value& response);
-	void libraryGetFileIdsOfAlbum(const Json::Value& request, Json::Value& response);
+	void libraryGetFiles(const JsonValue& request, ResponseWriter& response);
+	void libraryGetFileIdsOfAlbum(const JsonValue& request, ResponseWriter& response);
 
 	// library - directories
-	void libraryGetDirectories(const Json::Value& request, Json::Value& response);
+	void libraryGetDirectories(const JsonValue& request, ResponseWriter& response);
+
+	// library - listings, the objects of the library are returned page by page ordered by their ids
+	void libraryListArtists(const JsonValue& request, ResponseWriter& response);
+	void libraryListAlbums(const JsonValue& request, ResponseWriter& response);
+	void libraryListFiles(const JsonValue& request, ResponseWriter& response);
+
+	// library - changes, returns the ids of the objects added, modified or deleted since the given generation
+	void libraryGetChanges(const JsonValue& request, ResponseWriter& response);
 
 	// library - metadata
-	void libraryUpdateMetadata(const Json::Value& request, Json::Value& response);
+	void libraryUpdateMetadata(const JsonValue& request, ResponseWriter& response);
 
 	// library - playlists
-	void libraryCreatePlaylist(const Json::Value& request, Json::Value& response);
-	void libraryDeletePlaylist(const Json::Value& request, Json::Value& response);
-	void libraryAddPlaylistItem(const Json::Value& request, Json::Value& response);
-	void libraryDeletePlaylistItem(const Json::Value& request, Json::Value& response);
-	void libraryGetPlaylists(const Json::Value& request, Json::Value& response);
-
-	// player - queue
-	void playerQueueFile(const Json::Value& request, Json::Value& response);
-	void playerQueueDirectory(const Json::Value& request, Json::Value& response);
-	void playerQueueAlbum(const Json::Value& request, Json::Value& response);
-	void playerQueuePlaylist(const Json::Value& request, Json::Value& response);
-	void playerQueueGet(const Json::Value& request, Json::Value& response);
-	void playerQueueRemove(const Json::Value& request, Json::Value& response);
-	void playerQueueRemoveAll(const Json::Value& request, Json::Value& response);
-
-	void playerStatus(const Json::Value& request, Json::Value& response);
-
-	void playerPlay(const Json::Value& request, Json::Value& response);
-	void playerPause(const Json::Value& request, Json::Value& response);
-	void playerStop(const Json::Value& request, Json::Value& response);
-	void playerSeek(const Json::Value& request, Json::Value& response);
-	void playerPrev(const Json::Value& request, Json::Value& response);
-	void playerNext(const Json::Value& request, Json::Value& response);
-	void playerGoto(const Json::Value& request, Json::Value& response);
-
-	void playerGetVolume(const Json::Value& request, Json::Value& response);
-	void playerSetVolume(const Json::Value& request, Json::Value& response);
-
-	void requireType(const Json::Value& request, const std::string& key, Json::ValueType type);
+	void libraryCreatePlaylist(const JsonValue& request, ResponseWriter& response);
+	void libraryDeletePlaylist(const JsonValue& request, ResponseWriter& response);
+	void libraryAddPlaylistItem(const JsonValue& request, ResponseWriter& response);
+	void libraryDeletePlaylistItem(const JsonValue& request, ResponseWriter& response);
+	void libraryGetPlaylists(const JsonValue& request, ResponseWriter& response);
+
+	// player - queue; the calls changing the queue take effect after the pending asynchronous queue calls, the
+	// queue follows the order of the calls even if a synchronous one is made while a job is still building its item
+	void playerQueueFile(const JsonValue& request, ResponseWriter& response);
+	void playerQueueDirectory(const JsonValue& request, ResponseWriter& response);
+	void playerQueueAlbum(const JsonValue& request, ResponseWriter& response);
+	// queues every album of the given list, the albums are loaded together
+	void playerQueueAlbums(const JsonValue& request, ResponseWriter& response);
+	void playerQueuePlaylist(const JsonValue& request, ResponseWriter& response);
+	void playerQueueGet(const JsonValue& request, ResponseWriter& response);
+	void playerQueueRemove(const JsonValue& request, ResponseWriter& response);
+	void playerQueueRemoveAll(const JsonValue& request, ResponseWriter& response);
+
+	void playerStatus(const JsonValue& request, ResponseWriter& response);
+	// blocks until the status differs from the given version and returns the changed members only
+	void playerWaitStatus(const JsonValue& request, ResponseWriter& response);
+
+	void playerPlay(const JsonValue& request, ResponseWriter& response);
+	void playerPause(const JsonValue& request, ResponseWriter& response);
+	void playerStop(const JsonValue& request, ResponseWriter& response);
+	void playerSeek(const JsonValue& request, ResponseWriter& response);
+	void playerPrev(const JsonValue& request, ResponseWriter& response);
+	void playerNext(const JsonValue& request, ResponseWriter& response);
+	void playerGoto(const JsonValue& request, ResponseWriter& response);
+
+	// player - background jobs of the queue methods called with async set to true
+	void jobStatus(const JsonValue& request, ResponseWriter& response);
+	void jobCancel(const JsonValue& request, ResponseWriter& response);
+
+	void playerGetVolume(const JsonValue& request, ResponseWriter& response);
+	void playerSetVolume(const JsonValue& request, ResponseWriter& response);
+
+	// server - metrics, returns the call counters and latency histograms of the methods called so far
+	void serverGetMetrics(const JsonValue& request, ResponseWriter& response);
+
+	void requireType(const JsonValue& request, const char* key, Json::ValueType type);
+
+	// sorted ids of the objects of a kind, used for paginating the listings
+	struct IdIndex
+	{
+	    IdIndex() : m_generation(0) {}
+
+	    unsigned long long m_generation;
+	    std::shared_ptr<const std::vector<int>> m_ids;
+	};
+
+	// returns the index valid for the current scan generation, it is built with the given function if needed
+	std::shared_ptr<const std::vector<int>> getIdIndex(IdIndex& index, const std::function<std::vector<int>()>& load);
+
+	// appends the item to the queue of the player in order with the pending asynchronous queue calls
+	void queue(const std::shared_ptr<zeppelin::player::QueueItem>& item);
 
 	std::shared_ptr<zeppelin::player::Album> createAlbum(int albumId);
+	// the result contains nullptr for the ids of unknown albums
+	std::vector<std::shared_ptr<zeppelin::player::Album>> createAlbums(const std::vector<int>& albumIds);
 	std::shared_ptr<zeppelin::player::Directory> createDirectory(int directoryId);
+	// builds a separate tree for each of the given ids, the trees are loaded level by level with one query for the
+	// directories and one for the files of each level; the result contains nullptr for the ids of unknown directories
+	std::vector<std::shared_ptr<zeppelin::player::Directory>> createDirectories(const std::vector<int>& directoryIds);
+	std::shared_ptr<zeppelin::player::Playlist> createPlaylist(int playlistId);
 
     private:
 	std::shared_ptr<zeppelin::library::MusicLibrary> m_library;
 	std::shared_ptr<zeppelin::player::Controller> m_ctrl;
 
-	typedef std::function<void(const Json::Value&, Json::Value&)> RpcMethod;
+	// notifies the long polling clients about player status changes
+	StatusWatcher m_statusWatcher;
+	// bumps the generations when a scan is started or finished
+	ScanWatcher m_scanWatcher;
+
+	enum RpcFlags
+	{
+	    RPC_WRITE = 0,
+	    // the method does not change any state, it can be executed in parallel with other read-only methods
+	    RPC_READ = 1 << 0,
+	    // the result depends only on the contents of the library, it is tagged with the library generation
+	    RPC_LIBRARY = 1 << 1
+	};
+
+	typedef void (Server::*RpcFunction)(const JsonValue&, ResponseWriter&);
+
+	struct RpcMethod
+	{
+	    const char* m_name;
+	    RpcFunction m_function;
+	    int m_flags;
+	};
+
+	static const RpcMethod s_rpcMethods[];
+
+	static constexpr bool isSorted(const RpcMethod* methods, size_t count);
+	// returns nullptr if there is no method with the given name
+	static const RpcMethod* findRpcMethod(const char* name, size_t size);
+	// names of the methods in the order of the table, used for indexing the metrics
+	static std::vector<const char*> getRpcMethodNames();
+
+	void recordCall(const RpcMethod* method,
+			const std::chrono::steady_clock::time_point& begin,
+			size_t responseBytes,
+			bool error);
+
+	// workers used for executing the calls of batch requests
+	ThreadPool m_workers;
+
+	// serialized album pictures for each response format, tagged with the scan generation they were loaded in
+	PictureCache m_pictureCaches[ResponseWriter::FORMAT_COUNT];
+
+	// ids of the library objects changed in the recent generations
+	ChangeLog m_changeLog;
+
+	Metrics m_metrics;
+
+	// builds the items of asynchronous queue calls, the synchronous changes of the queue are ordered with them too
+	JobQueue m_jobs;
+
+	size_t m_compressionMinSize;
+	int m_compressionLevel;
+
+	// incremented every time the contents of the library are changed
+	std::atomic<unsigned long long> m_libraryGeneration;
+	// incremented when a scan is started or finished
+	std::atomic<unsigned long long> m_scanGeneration;
 
-	std::unordered_map<std::string, RpcMethod> m_rpcMethods;
+	std::mutex m_indexMutex;
+	IdIndex m_artistIndex;
+	IdIndex m_albumIndex;
+	IdIndex m_fileIndex;
 };
 
 #endif
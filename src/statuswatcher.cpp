@@ -0,0 +1,154 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "statuswatcher.h"
+
+#include <chrono>
+
+// number of old statuses kept for sending only the changed fields to clients being a few versions behind
+static const size_t HISTORY_SIZE = 16;
+
+// =====================================================================================================================
+StatusWatcher::StatusWatcher(const std::shared_ptr<zeppelin::player::Controller>& ctrl)
+    : m_ctrl(ctrl),
+      m_interval(0),
+      m_running(false),
+      // versions continue from the current time in microseconds, the versions a client kept from an earlier run of
+      // the plugin are always older than the history and get the full status instead of a delta to unknown statuses
+      m_version(std::chrono::duration_cast<std::chrono::microseconds>(
+		    std::chrono::system_clock::now().time_since_epoch()).count())
+{
+}
+
+// =====================================================================================================================
+StatusWatcher::~StatusWatcher()
+{
+    stop();
+}
+
+// =====================================================================================================================
+void StatusWatcher::start(int interval)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_running)
+	return;
+
+    m_interval = interval;
+    m_running = true;
+
+    m_history.clear();
+    m_history.push_back(m_ctrl->getStatus());
+    ++m_version;
+
+    m_thread = std::thread(&StatusWatcher::run, this);
+}
+
+// =====================================================================================================================
+void StatusWatcher::stop()
+{
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (!m_running)
+	    return;
+
+	m_running = false;
+    }
+
+    // wakes up the sampler thread and the waiting callers as well
+    m_cond.notify_all();
+
+    m_thread.join();
+}
+
+// =====================================================================================================================
+StatusWatcher::Change StatusWatcher::wait(unsigned long long version, int timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    Change change;
+    change.m_hasPrevious = false;
+
+    if (!m_running)
+    {
+	change.m_version = m_version;
+	change.m_status = m_ctrl->getStatus();
+	return change;
+    }
+
+    // the oldest version still in the history
+    unsigned long long first = m_version - m_history.size() + 1;
+
+    if (version == m_version)
+    {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+	while (m_running && m_version == version)
+	{
+	    if (m_cond.wait_until(lock, deadline) == std::cv_status::timeout)
+		break;
+	}
+
+	first = m_version - m_history.size() + 1;
+    }
+
+    if (version >= first && version <= m_version)
+    {
+	change.m_hasPrevious = true;
+	change.m_previous = m_history[version - first];
+    }
+
+    change.m_version = m_version;
+    change.m_status = m_history.back();
+
+    return change;
+}
+
+// =====================================================================================================================
+void StatusWatcher::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (m_running)
+    {
+	m_cond.wait_for(lock, std::chrono::milliseconds(m_interval));
+
+	if (!m_running)
+	    break;
+
+	// the controller is queried without holding the lock to keep the waiting callers responsive
+	lock.unlock();
+	zeppelin::player::Controller::Status status = m_ctrl->getStatus();
+	lock.lock();
+
+	if (isEqual(status, m_history.back()))
+	    continue;
+
+	m_history.push_back(status);
+
+	if (m_history.size() > HISTORY_SIZE)
+	    m_history.pop_front();
+
+	++m_version;
+
+	m_cond.notify_all();
+    }
+}
+
+// =====================================================================================================================
+bool StatusWatcher::isEqual(const zeppelin::player::Controller::Status& s1,
+			    const zeppelin::player::Controller::Status& s2)
+{
+    int file1 = s1.m_file ? s1.m_file->m_id : -1;
+    int file2 = s2.m_file ? s2.m_file->m_id : -1;
+
+    return file1 == file2 &&
+	s1.m_state == s2.m_state &&
+	s1.m_position == s2.m_position &&
+	s1.m_volume == s2.m_volume &&
+	s1.m_index == s2.m_index;
+}
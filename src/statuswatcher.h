@@ -0,0 +1,66 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_STATUSWATCHER_H_INCLUDED
+#define JSONRPCREMOTE_STATUSWATCHER_H_INCLUDED
+
+#include <zeppelin/player/controller.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * Samples the status of the player periodically and assigns a new version to it every time it changes, callers can
+ * block until the status gets newer than the version they have already seen.
+ */
+class StatusWatcher
+{
+    public:
+	struct Change
+	{
+	    unsigned long long m_version;
+	    zeppelin::player::Controller::Status m_status;
+
+	    // true if the status belonging to the version the caller knew about is still available in m_previous
+	    bool m_hasPrevious;
+	    zeppelin::player::Controller::Status m_previous;
+	};
+
+	StatusWatcher(const std::shared_ptr<zeppelin::player::Controller>& ctrl);
+	~StatusWatcher();
+
+	void start(int interval);
+	void stop();
+
+	/**
+	 * Waits at most timeout milliseconds for a status newer than the given version. Returns immediately if the
+	 * version is unknown or the watcher is not running.
+	 */
+	Change wait(unsigned long long version, int timeout);
+
+    private:
+	void run();
+
+	static bool isEqual(const zeppelin::player::Controller::Status& s1, const zeppelin::player::Controller::Status& s2);
+
+    private:
+	std::shared_ptr<zeppelin::player::Controller> m_ctrl;
+
+	int m_interval;
+	bool m_running;
+	std::thread m_thread;
+
+	unsigned long long m_version;
+	// the recent statuses, the one belonging to m_version is at the back
+	std::deque<zeppelin::player::Controller::Status> m_history;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+};
+
+#endif
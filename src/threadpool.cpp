@@ -0,0 +1,108 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#include "threadpool.h"
+
+// =====================================================================================================================
+ThreadPool::ThreadPool()
+    : m_running(false)
+{
+}
+
+// =====================================================================================================================
+ThreadPool::~ThreadPool()
+{
+    stop();
+}
+
+// =====================================================================================================================
+void ThreadPool::start(int workers)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_running || workers <= 0)
+	return;
+
+    m_running = true;
+
+    for (int i = 0; i < workers; ++i)
+	m_workers.emplace_back(&ThreadPool::worker, this);
+}
+
+// =====================================================================================================================
+void ThreadPool::stop()
+{
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (!m_running)
+	    return;
+
+	m_running = false;
+    }
+
+    m_cond.notify_all();
+
+    for (auto& t : m_workers)
+	t.join();
+
+    m_workers.clear();
+}
+
+// =====================================================================================================================
+bool ThreadPool::isRunning() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+// =====================================================================================================================
+std::future<void> ThreadPool::submit(const std::function<void()>& task)
+{
+    std::packaged_task<void()> t(task);
+    std::future<void> f = t.get_future();
+
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_running)
+	{
+	    m_tasks.push_back(std::move(t));
+	    m_cond.notify_one();
+	    return f;
+	}
+    }
+
+    // the pool is not running, execute the task right here
+    t();
+
+    return f;
+}
+
+// =====================================================================================================================
+void ThreadPool::worker()
+{
+    while (1)
+    {
+	std::packaged_task<void()> task;
+
+	{
+	    std::unique_lock<std::mutex> lock(m_mutex);
+
+	    while (m_running && m_tasks.empty())
+		m_cond.wait(lock);
+
+	    // finish the queued tasks before exiting to make sure nobody waits on a future forever
+	    if (m_tasks.empty())
+		return;
+
+	    task = std::move(m_tasks.front());
+	    m_tasks.pop_front();
+	}
+
+	task();
+    }
+}
@@ -0,0 +1,53 @@
+/**
+ * This file is part of the Zeppelin music player project.
+ * Copyright (c) 2013-2014 Zoltan Kovacs, Lajos Santa
+ * See http://zeppelin-player.com for more details.
+ */
+
+#ifndef JSONRPCREMOTE_THREADPOOL_H_INCLUDED
+#define JSONRPCREMOTE_THREADPOOL_H_INCLUDED
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+
+/**
+ * Fixed size pool of worker threads executing queued tasks in FIFO order.
+ */
+class ThreadPool
+{
+    public:
+	ThreadPool();
+	~ThreadPool();
+
+	void start(int workers);
+	void stop();
+
+	/**
+	 * Returns true if the pool has running workers and tasks submitted to it are executed in the background.
+	 */
+	bool isRunning() const;
+
+	/**
+	 * Queues the given task for execution. If the pool is not running the task is executed on the calling thread.
+	 */
+	std::future<void> submit(const std::function<void()>& task);
+
+    private:
+	void worker();
+
+    private:
+	bool m_running;
+
+	std::vector<std::thread> m_workers;
+	std::deque<std::packaged_task<void()>> m_tasks;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cond;
+};
+
+#endif